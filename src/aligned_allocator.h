@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Allocator returning memory aligned to `Alignment` bytes, e.g., to let
+// coordinate arrays start at a cache line such that vector loads never split
+// a line.
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator
+{
+	static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+		"Alignment has to be a power of two and at least alignof(T)");
+
+	using value_type = T;
+
+	template <typename U>
+	struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(AlignedAllocator<U, Alignment> const&) {}
+
+	T* allocate(std::size_t n)
+	{
+		void* ptr = nullptr;
+		if (posix_memalign(&ptr, Alignment, n*sizeof(T)) != 0) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(ptr);
+	}
+	void deallocate(T* ptr, std::size_t) { std::free(ptr); }
+
+	template <typename U>
+	bool operator==(AlignedAllocator<U, Alignment> const&) const { return true; }
+	template <typename U>
+	bool operator!=(AlignedAllocator<U, Alignment> const&) const { return false; }
+};
+
+constexpr std::size_t cache_line_size = 64;
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, cache_line_size>>;
@@ -0,0 +1,44 @@
+#include "defs.h"
+#include "distance_matrix.h"
+#include "query.h"
+
+#include <chrono>
+#include <string>
+
+void printUsage()
+{
+	std::cout <<
+		"Usage: ./calc_distance_matrix <curve_directory> <curve_data_file> <out_file> [<band>]\n"
+		"\n"
+		"Computes the Frechet distances of all pairs of curves listed in the curve\n"
+		"data file (or in a curve store) and writes them to a binary distance matrix.\n"
+		"With <band>, only pairs of curves which are at most <band> apart in the\n"
+		"curve data file are computed.\n"
+		"\n";
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4 && argc != 5) {
+		printUsage();
+		ERROR("Wrong number of arguments passed.");
+	}
+
+	std::string curve_directory(argv[1]);
+	std::string curve_data_file(argv[2]);
+	std::string out_file(argv[3]);
+	std::size_t band = argc == 5 ? std::stoul(argv[4]) : 0;
+
+	Query query(curve_directory);
+	query.readCurveData(curve_data_file);
+
+	auto start = std::chrono::steady_clock::now();
+	DistanceMatrix matrix;
+	matrix.compute(query.getCurves(), band);
+	auto end = std::chrono::steady_clock::now();
+	matrix.write(out_file);
+
+	std::cout << "Computed the distance matrix of " << matrix.size() << " curves in "
+		<< std::chrono::duration<double>(end - start).count() << " s and wrote it to "
+		<< out_file << "\n";
+}
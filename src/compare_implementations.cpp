@@ -11,7 +11,7 @@ void printUsage()
 {
 	std::cout <<
 		"Usage: ./frechet <curve_directory> <curve_data_file> <query_file_prefix> <result_file_prefix> <alg_string> <?performance_test>\n"
-		"With <alg_string> you choose the algorithm to be used (normal, light, naive)."
+		"With <alg_string> you choose the algorithm to be used (normal, light, naive, wavefront)."
 		"\n";
 }
 
@@ -50,55 +50,36 @@ int main(int argc, char* argv[])
 		auto k = ks[i];
 
 		std::cout << "Creating benchmark for k=" << k << ".\n";
-		query.setAlgorithm("light");
 		std::vector<QueryPair> query_pairs;
 		unsigned int epsilon_ball_rejects = 0;
 		while (query_pairs.size() < 1000) {
 
 			Curve const& query_curve = getRandomCurve(query);
-			distance_t lower_bound = 0.;
-			distance_t upper_bound = query.getUpperBoundDistance();
-			distance_t query_distance;
-
-			bool distance_found = false;
-			int rounds = 0;
-			int const rounds_max = 100;
-			while (!distance_found && rounds < rounds_max) {
-				query_distance = lower_bound + (upper_bound - lower_bound)/2.;
-				query.run(query_curve, query_distance);
-
-				auto result_size = query.getResults()[0].curve_ids.size();
-				if (result_size > k+1) {
-					upper_bound = query_distance;
-				}
-				else if (result_size < k+1) {
-					lower_bound = query_distance;
-				}
-				else {
-					// Check that there is an epsilon ball around this distance
-					// which also has the same result size. If this is not the
-					// case then we just drop this random curve.
-					query.run(query_curve, query_distance - epsilon);
-					auto result_size_minus = query.getResults()[0].curve_ids.size();
-					query.run(query_curve, query_distance + epsilon);
-					auto result_size_plus = query.getResults()[0].curve_ids.size();
-
-					if (result_size_minus == result_size_plus) {
-						distance_found = true;
-					}
-					else {
-						++epsilon_ball_rejects;
-						break;
-					}
-				}
-
-				++rounds;
+
+			// The k+1 nearest curves (including the query curve itself) are
+			// the result for any distance between the distances of the
+			// (k+1)-th and the (k+2)-th nearest curve. We require an epsilon
+			// ball around the query distance where the result size remains
+			// the same. If there is none, then we just drop this random curve.
+			query.runKnn(query_curve, k+1);
+			if (query.getResults()[0].curve_ids.size() < k+1) {
+				ERROR("There are less than " << k+1 << " curves.");
+			}
+			auto const lower_distance = query.getResults()[0].kth_distance;
+			auto upper_distance = lower_distance + 4*epsilon;
+			if (query.getCurves().size() > k+1) {
+				query.runKnn(query_curve, k+2);
+				upper_distance = query.getResults()[0].kth_distance;
 			}
+			auto const query_distance = lower_distance + (upper_distance - lower_distance)/2.;
 
-			if (distance_found) {
+			if (upper_distance - lower_distance > 2*epsilon) {
 				query_pairs.emplace_back(query_curve, query_distance);
 				std::cout << "." << std::flush;
 			}
+			else {
+				++epsilon_ball_rejects;
+			}
 
 			// XXX: avoids allocating huge amounts of memory just for the timing data
 			global::times.reset();
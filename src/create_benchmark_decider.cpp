@@ -92,7 +92,7 @@ int main(int argc, char* argv[])
 		std::vector<std::pair<double, CurveID>> distance_curve_pairs;
 		for (std::size_t curve_id = 0; curve_id < query.getCurves().size(); ++curve_id) {
 			auto curve = query.getCurves()[curve_id];
-			auto distance = frechet.calcDistance(curve1, curve);
+			auto distance = frechet.calcDistanceExact(curve1, curve);
 			distance_curve_pairs.emplace_back(distance, curve_id);
 		}
 		std::sort(distance_curve_pairs.begin(), distance_curve_pairs.end());
@@ -101,7 +101,7 @@ int main(int argc, char* argv[])
 			auto k = ks[k_index];
 			auto curve2_index = getIndexInRange(query, k);
 			auto const& curve2 = query.getCurves()[distance_curve_pairs[curve2_index].second];
-			auto delta_star = frechet.calcDistance(curve1, curve2);
+			auto delta_star = distance_curve_pairs[curve2_index].first;
 
 			for (std::size_t l_index = 0; l_index < ls_minus.size(); ++l_index) {
 				auto l = ls_minus[l_index];
@@ -0,0 +1,45 @@
+#include "defs.h"
+#include "curve_store.h"
+#include "query.h"
+
+#include <string>
+
+void printUsage()
+{
+	std::cout <<
+		"Usage: ./create_curve_store <curve_directory> <curve_data_file> <out_file> [--index]\n"
+		"\n"
+		"Reads all curves listed in the curve data file and writes them to a binary\n"
+		"curve store. The store can be passed instead of the curve data file to all\n"
+		"tools which use Query::readCurveData (the curve directory is then ignored).\n"
+		"\n"
+		"With --index, the kd-tree and the curve signatures are built and saved\n"
+		"together with the curves as an index snapshot, which is loaded without\n"
+		"any rebuild.\n"
+		"\n";
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4 && !(argc == 5 && std::string(argv[4]) == "--index")) {
+		printUsage();
+		ERROR("Wrong number of arguments passed.");
+	}
+
+	std::string curve_directory(argv[1]);
+	std::string curve_data_file(argv[2]);
+	std::string out_file(argv[3]);
+	bool const with_index = (argc == 5);
+
+	Query query(curve_directory);
+	query.readCurveData(curve_data_file);
+	if (with_index) {
+		query.getReady();
+		query.saveIndex(out_file);
+	}
+	else {
+		CurveStore::write(out_file, query.getCurves());
+	}
+
+	std::cout << "Wrote " << query.getCurves().size() << " curves to " << out_file << "\n";
+}
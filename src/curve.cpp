@@ -1,17 +1,27 @@
 #include "curve.h"
 
+#include <algorithm>
+
+constexpr std::size_t Curve::padding;
+
 Curve::Curve(const Points& points)
-	: points(points), prefix_length(points.size())
+	: x(paddedSize(points.size())), y(paddedSize(points.size())),
+	  prefix_length(paddedSize(points.size())), num_points(points.size())
 {
+	updateDataPointers();
 	if (points.empty()) { return; }
 
 	auto const& front = points.front();
 	extreme_points = { front.x, front.y, front.x, front.y };
+	x[0] = front.x;
+	y[0] = front.y;
 	prefix_length[0] = 0;
 
 	for (PointID i = 1; i < points.size(); ++i)
 	{
 		auto segment_distance = points[i - 1].dist(points[i]);
+		x[i] = points[i].x;
+		y[i] = points[i].y;
 		prefix_length[i] = prefix_length[i - 1] + segment_distance;
 
 		extreme_points.min_x = std::min(extreme_points.min_x, points[i].x);
@@ -19,24 +29,159 @@ Curve::Curve(const Points& points)
 		extreme_points.max_x = std::max(extreme_points.max_x, points[i].x);
 		extreme_points.max_y = std::max(extreme_points.max_y, points[i].y);
 	}
+
+	fillPadding();
+}
+
+Curve::Curve(distance_t const* x, distance_t const* y, distance_t const* prefix_length,
+             std::size_t size, ExtremePoints const& extreme_points)
+	: x_data(x), y_data(y), prefix_data(prefix_length), num_points(size), view(true),
+	  extreme_points(extreme_points)
+{
+}
+
+Curve::Curve(Curve const& other)
+	: filename(other.filename), x(other.x), y(other.y), prefix_length(other.prefix_length),
+	  x_data(other.x_data), y_data(other.y_data), prefix_data(other.prefix_data),
+	  num_points(other.num_points), view(other.view), extreme_points(other.extreme_points)
+{
+	if (!view) { updateDataPointers(); }
+}
+
+Curve::Curve(Curve&& other)
+	: filename(std::move(other.filename)), x(std::move(other.x)), y(std::move(other.y)),
+	  prefix_length(std::move(other.prefix_length)),
+	  x_data(other.x_data), y_data(other.y_data), prefix_data(other.prefix_data),
+	  num_points(other.num_points), view(other.view), extreme_points(other.extreme_points)
+{
+	// the moved vectors keep their buffers, so the data pointers stay valid
+	other.x.clear();
+	other.y.clear();
+	other.prefix_length.clear();
+	other.num_points = 0;
+	other.updateDataPointers();
+}
+
+Curve& Curve::operator=(Curve const& other)
+{
+	if (this != &other) {
+		*this = Curve(other);
+	}
+	return *this;
+}
+
+Curve& Curve::operator=(Curve&& other)
+{
+	if (this != &other) {
+		filename = std::move(other.filename);
+		x = std::move(other.x);
+		y = std::move(other.y);
+		prefix_length = std::move(other.prefix_length);
+		x_data = other.x_data;
+		y_data = other.y_data;
+		prefix_data = other.prefix_data;
+		num_points = other.num_points;
+		view = other.view;
+		extreme_points = other.extreme_points;
+
+		other.x.clear();
+		other.y.clear();
+		other.prefix_length.clear();
+		other.num_points = 0;
+		other.updateDataPointers();
+	}
+	return *this;
+}
+
+void Curve::updateDataPointers()
+{
+	view = false;
+	x_data = x.data();
+	y_data = y.data();
+	prefix_data = prefix_length.data();
+}
+
+// Views are read-only, so before modifying a view we copy the data it refers to.
+void Curve::detachFromView()
+{
+	auto padded_size = paddedSize(num_points);
+	x.assign(x_data, x_data + padded_size);
+	y.assign(y_data, y_data + padded_size);
+	prefix_length.assign(prefix_data, prefix_data + padded_size);
+	updateDataPointers();
+}
+
+// Repeats the last point up to the end of the padded arrays.
+void Curve::fillPadding()
+{
+	if (num_points == 0) { return; }
+
+	auto last = num_points - 1;
+	std::fill(x.begin() + num_points, x.end(), x[last]);
+	std::fill(y.begin() + num_points, y.end(), y[last]);
+	std::fill(prefix_length.begin() + num_points, prefix_length.end(), prefix_length[last]);
 }
 
 void Curve::push_back(Point const& point)
 {
-	if (prefix_length.size()) {
-		auto segment_distance = points.back().dist(point);
-		prefix_length.push_back(prefix_length.back() + segment_distance);
+	if (view) { detachFromView(); }
+
+	if (num_points == x.size()) {
+		x.resize(x.size() + padding);
+		y.resize(y.size() + padding);
+		prefix_length.resize(prefix_length.size() + padding);
+		updateDataPointers();
+	}
+
+	if (num_points > 0) {
+		auto segment_distance = back().dist(point);
+		prefix_length[num_points] = prefix_length[num_points - 1] + segment_distance;
 	}
 	else {
-		prefix_length.push_back(0);
+		prefix_length[num_points] = 0;
 	}
+	x[num_points] = point.x;
+	y[num_points] = point.y;
+	++num_points;
 
 	extreme_points.min_x = std::min(extreme_points.min_x, point.x);
 	extreme_points.min_y = std::min(extreme_points.min_y, point.y);
 	extreme_points.max_x = std::max(extreme_points.max_x, point.x);
 	extreme_points.max_y = std::max(extreme_points.max_y, point.y);
 
-	points.push_back(point);
+	fillPadding();
+}
+
+void Curve::reserve(std::size_t capacity)
+{
+	if (view) { detachFromView(); }
+
+	x.reserve(paddedSize(capacity));
+	y.reserve(paddedSize(capacity));
+	prefix_length.reserve(paddedSize(capacity));
+	updateDataPointers();
+}
+
+// The points are processed in blocks of `padding` points with an early exit
+// after each block. The loop within a block is vectorized.
+bool Curve::allPointsWithin(Point const& point, PointID begin, PointID end, distance_t dist_sqr) const
+{
+	assert(begin <= end && end < size());
+
+	std::size_t const last = end;
+	for (std::size_t block = begin; block <= last; block += padding) {
+		auto block_end = std::min(block + padding, last + 1);
+		distance_t max_dist_sqr = 0;
+#pragma omp simd reduction(max:max_dist_sqr)
+		for (std::size_t i = block; i < block_end; ++i) {
+			auto dx = x_data[i] - point.x;
+			auto dy = y_data[i] - point.y;
+			max_dist_sqr = std::max(max_dist_sqr, dx*dx + dy*dy);
+		}
+		if (max_dist_sqr > dist_sqr) { return false; }
+	}
+
+	return true;
 }
 
 auto Curve::getExtremePoints() const -> ExtremePoints const&
@@ -1,51 +1,140 @@
 #pragma once
 
+#include "aligned_allocator.h"
 #include "defs.h"
 #include "geometry_basics.h"
 #include "id.h"
 
+#include <iterator>
+
 // Represents a trajectory. Additionally to the points given in the input file,
 // we also store the length of any prefix of the trajectory.
+//
+// The coordinates are stored as a structure of arrays, i.e., all x coordinates,
+// all y coordinates and all prefix lengths are contiguous. The arrays start at a
+// cache line and are padded to a multiple of `padding` entries by repeating the
+// last point, such that loops over the points can be vectorized without
+// treating the remainder separately.
+//
+// A curve either owns its points or is a read-only view on coordinates and
+// prefix lengths stored somewhere else (e.g. in a memory-mapped CurveStore).
 class Curve
 {
 public:
+	struct ExtremePoints { distance_t min_x, min_y, max_x, max_y; };
+
+	// number of coordinates per cache line
+	static constexpr std::size_t padding = cache_line_size / sizeof(distance_t);
+	static std::size_t paddedSize(std::size_t size)
+		{ return (size + padding - 1) / padding * padding; }
+
+	// Random access iterator over the points. As the points are not stored
+	// as such, dereferencing returns the point by value.
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Point;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Point;
+
+		const_iterator(Curve const* curve = nullptr, std::size_t index = 0)
+			: curve(curve), index(index) {}
+
+		Point operator*() const { return (*curve)[index]; }
+		Point operator[](difference_type n) const { return (*curve)[index + n]; }
+
+		const_iterator& operator++() { ++index; return *this; }
+		const_iterator& operator--() { --index; return *this; }
+		const_iterator operator++(int) { auto it = *this; ++index; return it; }
+		const_iterator operator--(int) { auto it = *this; --index; return it; }
+		const_iterator& operator+=(difference_type n) { index += n; return *this; }
+		const_iterator& operator-=(difference_type n) { index -= n; return *this; }
+		const_iterator operator+(difference_type n) const { return {curve, index + n}; }
+		const_iterator operator-(difference_type n) const { return {curve, index - n}; }
+		difference_type operator-(const_iterator const& other) const
+			{ return difference_type(index) - difference_type(other.index); }
+
+		bool operator==(const_iterator const& other) const { return index == other.index; }
+		bool operator!=(const_iterator const& other) const { return index != other.index; }
+		bool operator<(const_iterator const& other) const { return index < other.index; }
+		bool operator>(const_iterator const& other) const { return index > other.index; }
+		bool operator<=(const_iterator const& other) const { return index <= other.index; }
+		bool operator>=(const_iterator const& other) const { return index >= other.index; }
+
+	private:
+		Curve const* curve;
+		std::size_t index;
+	};
+
     Curve() = default;
     Curve(const Points& points);
+	// The arrays have to be padded as described above.
+	Curve(distance_t const* x, distance_t const* y, distance_t const* prefix_length,
+	      std::size_t size, ExtremePoints const& extreme_points);
+	Curve(Curve const& other);
+	Curve(Curve&& other);
+	Curve& operator=(Curve const& other);
+	Curve& operator=(Curve&& other);
 
-    std::size_t size() const { return points.size(); }
-	bool empty() const { return points.empty(); }
-    Point const& operator[](PointID i) const { return points[i]; }
+    std::size_t size() const { return num_points; }
+	bool empty() const { return num_points == 0; }
+    Point operator[](PointID i) const { return {x_data[i], y_data[i]}; }
 	Point interpolate_at(CPoint const& pt) const  {
 		assert(pt.getFraction() >= 0. && pt.getFraction() <= 1.);
-		assert((pt.getPoint() < points.size()-1 || (pt.getPoint() == points.size()-1 && pt.getFraction() == 0.)));
-		return pt.getFraction() == 0. ? points[pt.getPoint()] : points[pt.getPoint()]*(1.-pt.getFraction()) + points[pt.getPoint()+1]*pt.getFraction();
+		assert((pt.getPoint() < size()-1 || (pt.getPoint() == size()-1 && pt.getFraction() == 0.)));
+		return pt.getFraction() == 0. ? (*this)[pt.getPoint()] : (*this)[pt.getPoint()]*(1.-pt.getFraction()) + (*this)[pt.getPoint()+1]*pt.getFraction();
 	}
     distance_t curve_length(PointID i, PointID j) const
-		{ return prefix_length[j] - prefix_length[i]; }
+		{ return prefix_data[j] - prefix_data[i]; }
 
-    Point front() const { return points.front(); }
-    Point back() const { return points.back(); }
+    Point front() const { return (*this)[0]; }
+    Point back() const { return (*this)[num_points-1]; }
 
     void push_back(Point const& point);
+	void reserve(std::size_t capacity);
+	bool is_view() const { return view; }
+
+	const_iterator begin() const { return {this, 0}; }
+	const_iterator end() const { return {this, num_points}; }
+
+	// raw access to the padded coordinate arrays
+	distance_t const* xs() const { return x_data; }
+	distance_t const* ys() const { return y_data; }
+	distance_t const* prefix_lengths() const { return prefix_data; }
+
+	// Checks whether all points in [begin, end] have squared distance at most
+	// `dist_sqr` to `point`.
+	bool allPointsWithin(Point const& point, PointID begin, PointID end, distance_t dist_sqr) const;
 
-	Points::const_iterator begin() { return points.begin(); }
-	Points::const_iterator end() { return points.end(); }
-	Points::const_iterator begin() const { return points.cbegin(); }
-	Points::const_iterator end() const { return points.cend(); }
-	
 	std::string filename;
 
-	struct ExtremePoints { distance_t min_x, min_y, max_x, max_y; };
 	ExtremePoints const& getExtremePoints() const;
 	distance_t getUpperBoundDistance(Curve const& other) const;
 
 private:
-    Points points;
-    std::vector<distance_t> prefix_length;
+	// owned data (empty if this curve is a view)
+	AlignedVector<distance_t> x;
+	AlignedVector<distance_t> y;
+	AlignedVector<distance_t> prefix_length;
+
+	// the data which is actually accessed; points either to the vectors above
+	// or to external storage
+	distance_t const* x_data = nullptr;
+	distance_t const* y_data = nullptr;
+	distance_t const* prefix_data = nullptr;
+	std::size_t num_points = 0;
+	bool view = false;
+
 	ExtremePoints extreme_points = {
 		std::numeric_limits<distance_t>::max(), std::numeric_limits<distance_t>::max(),
 		std::numeric_limits<distance_t>::lowest(), std::numeric_limits<distance_t>::lowest()
 	};
+
+	void updateDataPointers();
+	void detachFromView();
+	void fillPadding();
 };
 using Curves = std::vector<Curve>;
 
@@ -0,0 +1,137 @@
+#include "curve_signatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+// extreme of the projections of the points onto a unit vector
+template <typename Compare>
+distance_t projectionExtreme(Curve const& curve, Point const& direction, Compare compare)
+{
+	auto project = [&](Point const& point) { return point.x*direction.x + point.y*direction.y; };
+
+	auto extreme = project(curve.front());
+	for (auto const& point: curve) {
+		extreme = std::max(extreme, project(point), compare);
+	}
+	return extreme;
+}
+
+distance_t maxDistanceTo(Curve const& curve, Point const& point)
+{
+	distance_t max_dist_sqr = 0.;
+	for (auto const& curve_point: curve) {
+		max_dist_sqr = std::max(max_dist_sqr, curve_point.dist_sqr(point));
+	}
+	return std::sqrt(max_dist_sqr);
+}
+
+} // end anonymous namespace
+
+auto CurveSignatures::defaultFeatures() -> Features
+{
+	// Each point of one curve has a point of the other curve within the
+	// distance, which changes a projection onto a unit vector by at most the
+	// distance. The start points are matched to each other, so the distance to
+	// the start point changes by at most twice the distance. Same for the end.
+	auto const inv_sqrt2 = 1/std::sqrt(distance_t(2.));
+	auto const diagonal = Point{inv_sqrt2, inv_sqrt2};
+	auto const antidiagonal = Point{inv_sqrt2, -inv_sqrt2};
+
+	return {
+		{"max_diagonal", 1., [=](Curve const& curve) {
+			return projectionExtreme(curve, diagonal, std::less<distance_t>()); }},
+		{"min_diagonal", 1., [=](Curve const& curve) {
+			return projectionExtreme(curve, diagonal, std::greater<distance_t>()); }},
+		{"max_antidiagonal", 1., [=](Curve const& curve) {
+			return projectionExtreme(curve, antidiagonal, std::less<distance_t>()); }},
+		{"min_antidiagonal", 1., [=](Curve const& curve) {
+			return projectionExtreme(curve, antidiagonal, std::greater<distance_t>()); }},
+		{"max_distance_to_start", 2., [](Curve const& curve) {
+			return maxDistanceTo(curve, curve.front()); }},
+		{"max_distance_to_end", 2., [](Curve const& curve) {
+			return maxDistanceTo(curve, curve.back()); }},
+	};
+}
+
+void CurveSignatures::addFeature(Feature const& feature)
+{
+	assert(feature.lipschitz > 0);
+	features.push_back(feature);
+	values.clear();
+}
+
+void CurveSignatures::compute(Curves const& curves)
+{
+	clear();
+	values.reserve(curves.size()*features.size());
+
+	for (auto const& curve: curves) {
+		add(curve);
+	}
+}
+
+void CurveSignatures::add(Curve const& curve)
+{
+	auto const curve_signature = signature(curve);
+	values.insert(values.end(), curve_signature.begin(), curve_signature.end());
+
+	auto const& extreme_points = curve.getExtremePoints();
+	for (auto coordinate: {extreme_points.min_x, extreme_points.min_y, extreme_points.max_x, extreme_points.max_y}) {
+		max_coordinate = std::max(max_coordinate, std::abs(coordinate));
+	}
+
+	slack = calcSlack(max_coordinate);
+}
+
+void CurveSignatures::assign(distance_t const* values, std::size_t num_values, distance_t max_coordinate)
+{
+	assert(num_values % features.size() == 0);
+
+	this->values.assign(values, values + num_values);
+	this->max_coordinate = max_coordinate;
+	slack = calcSlack(max_coordinate);
+}
+
+void CurveSignatures::clear()
+{
+	values.clear();
+	slack = 0.;
+	max_coordinate = 0.;
+}
+
+distance_t CurveSignatures::calcSlack(distance_t max_coordinate)
+{
+	// The features are computed by a few operations on the coordinates, so
+	// their rounding errors are a few units in the last place of them.
+	return 32*std::numeric_limits<distance_t>::epsilon()*max_coordinate;
+}
+
+auto CurveSignatures::signature(Curve const& curve) const -> Signature
+{
+	assert(curve.size());
+
+	Signature curve_signature;
+	curve_signature.reserve(features.size());
+	for (auto const& feature: features) {
+		curve_signature.push_back(feature.compute(curve));
+	}
+	return curve_signature;
+}
+
+distance_t CurveSignatures::lowerBound(Signature const& signature, std::size_t curve_index) const
+{
+	assert(signature.size() == features.size());
+	assert((curve_index + 1)*features.size() <= values.size());
+
+	auto const curve_values = &values[curve_index*features.size()];
+	distance_t lower_bound = 0.;
+	for (std::size_t i = 0; i < features.size(); ++i) {
+		auto const difference = std::abs(signature[i] - curve_values[i]) - slack;
+		lower_bound = std::max(lower_bound, difference/features[i].lipschitz);
+	}
+	return lower_bound;
+}
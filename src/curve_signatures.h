@@ -0,0 +1,69 @@
+#pragma once
+
+#include "defs.h"
+#include "geometry_basics.h"
+#include "curves.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace unit_tests { void testCurveSignatures(); }
+
+// Keys of curves beyond the start points, end points and bounding boxes which
+// are indexed by the kd-tree (see toKdPoint). Each feature f of a signature
+// is Lipschitz in the Frechet distance, i.e., |f(A) - f(B)| <= L*d_F(A, B).
+// Thus, max |f(A) - f(B)|/L over all features is a lower bound on the
+// distance, which prunes kd-tree candidates before any filter runs.
+//
+// Further features can be plugged in by addFeature() before the signatures of
+// the data curves are computed.
+class CurveSignatures
+{
+public:
+	using Signature = std::vector<distance_t>;
+	struct Feature
+	{
+		std::string name;
+		distance_t lipschitz;
+		std::function<distance_t(Curve const&)> compute;
+	};
+	using Features = std::vector<Feature>;
+
+	// The extremes in the diagonal directions, i.e., the bounding box rotated
+	// by 45 degrees (L = 1), and the largest distances of a point of the curve
+	// to its start and to its end point (L = 2).
+	static Features defaultFeatures();
+
+	CurveSignatures(Features const& features = defaultFeatures())
+		: features(features) {}
+
+	void addFeature(Feature const& feature);
+	Features const& getFeatures() const { return features; }
+
+	void compute(Curves const& curves);
+	// appends the signature of a further data curve
+	void add(Curve const& curve);
+	void clear();
+
+	// the signatures of the data curves one after another, e.g., to save them
+	std::vector<distance_t> const& getValues() const { return values; }
+	distance_t getMaxCoordinate() const { return max_coordinate; }
+	// restores saved signatures instead of computing them
+	void assign(distance_t const* values, std::size_t num_values, distance_t max_coordinate);
+
+	Signature signature(Curve const& curve) const;
+	// lower bound on the Frechet distance of a curve with the given signature
+	// to the data curve with the given index
+	distance_t lowerBound(Signature const& signature, std::size_t curve_index) const;
+
+private:
+	static distance_t calcSlack(distance_t max_coordinate);
+
+	Features features;
+	// the signatures of the data curves, one after another
+	std::vector<distance_t> values;
+	// bound on the rounding errors of the features
+	distance_t slack = 0.;
+	distance_t max_coordinate = 0.;
+};
@@ -0,0 +1,234 @@
+#include "curve_store.h"
+
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr uint64_t alignment = 64;
+
+uint64_t align(uint64_t pos)
+{
+	return (pos + alignment - 1) / alignment * alignment;
+}
+
+void writeAligned(std::ostream& file, uint64_t start, void const* data, uint64_t pos, uint64_t size)
+{
+	static char const zeros[alignment] = {};
+
+	auto current = static_cast<uint64_t>(file.tellp()) - start;
+	assert(current <= pos && pos - current < alignment);
+	file.write(zeros, pos - current);
+	file.write(static_cast<char const*>(data), size);
+}
+
+} // end anonymous namespace
+
+constexpr char const* CurveStore::magic;
+constexpr uint32_t CurveStore::version;
+
+CurveStore::~CurveStore()
+{
+	close();
+}
+
+bool CurveStore::isCurveStore(std::string const& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	char file_magic[8];
+	if (!file.read(file_magic, sizeof(file_magic))) { return false; }
+
+	return std::memcmp(file_magic, magic, sizeof(file_magic)) == 0;
+}
+
+void CurveStore::write(std::string const& filename, Curves const& curves)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		ERROR("Could not open curve store for writing: " << filename);
+	}
+
+	write(file, curves);
+
+	if (!file) {
+		ERROR("Error while writing curve store: " << filename);
+	}
+}
+
+void CurveStore::write(std::ostream& file, Curves const& curves)
+{
+	// the positions in the header are relative to the start of the store
+	auto const start = static_cast<uint64_t>(file.tellp());
+	assert(start % alignment == 0);
+
+	std::vector<uint64_t> point_offsets = {0};
+	std::vector<uint64_t> sizes;
+	std::vector<Curve::ExtremePoints> extremes;
+	std::vector<uint64_t> names_offsets = {0};
+	std::string all_names;
+	for (auto const& curve: curves) {
+		point_offsets.push_back(point_offsets.back() + Curve::paddedSize(curve.size()));
+		sizes.push_back(curve.size());
+		extremes.push_back(curve.getExtremePoints());
+		all_names += curve.filename;
+		names_offsets.push_back(all_names.size());
+	}
+
+	uint64_t num_points = point_offsets.back();
+	auto array_size = num_points*sizeof(distance_t);
+
+	Header header;
+	std::memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = version;
+	header.distance_size = sizeof(distance_t);
+	header.num_curves = curves.size();
+	header.num_points = num_points;
+	header.offsets_pos = align(sizeof(Header));
+	header.sizes_pos = align(header.offsets_pos + point_offsets.size()*sizeof(uint64_t));
+	header.extreme_points_pos = align(header.sizes_pos + sizes.size()*sizeof(uint64_t));
+	header.x_pos = align(header.extreme_points_pos + extremes.size()*sizeof(Curve::ExtremePoints));
+	header.y_pos = align(header.x_pos + array_size);
+	header.prefix_lengths_pos = align(header.y_pos + array_size);
+	header.name_offsets_pos = align(header.prefix_lengths_pos + array_size);
+	header.names_pos = align(header.name_offsets_pos + names_offsets.size()*sizeof(uint64_t));
+	header.file_size = header.names_pos + all_names.size();
+
+	// writes one of the padded coordinate arrays of all curves
+	auto write_array = [&](uint64_t pos, distance_t const* (Curve::*data)() const) {
+		writeAligned(file, start, nullptr, pos, 0);
+		for (auto const& curve: curves) {
+			auto bytes = Curve::paddedSize(curve.size())*sizeof(distance_t);
+			file.write(reinterpret_cast<char const*>((curve.*data)()), bytes);
+		}
+	};
+
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	writeAligned(file, start, point_offsets.data(), header.offsets_pos, point_offsets.size()*sizeof(uint64_t));
+	writeAligned(file, start, sizes.data(), header.sizes_pos, sizes.size()*sizeof(uint64_t));
+	writeAligned(file, start, extremes.data(), header.extreme_points_pos, extremes.size()*sizeof(Curve::ExtremePoints));
+	write_array(header.x_pos, &Curve::xs);
+	write_array(header.y_pos, &Curve::ys);
+	write_array(header.prefix_lengths_pos, &Curve::prefix_lengths);
+	writeAligned(file, start, names_offsets.data(), header.name_offsets_pos, names_offsets.size()*sizeof(uint64_t));
+	writeAligned(file, start, all_names.data(), header.names_pos, all_names.size());
+}
+
+void CurveStore::open(std::string const& filename)
+{
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		ERROR("Could not open curve store: " << filename);
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(Header)) {
+		::close(fd);
+		ERROR("Invalid curve store: " << filename);
+	}
+	mapping_size = file_stat.st_size;
+
+	mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		ERROR("Could not map curve store: " << filename);
+	}
+
+	attach(static_cast<char const*>(mapping), mapping_size, filename);
+}
+
+void CurveStore::open(char const* data, std::size_t size)
+{
+	close();
+
+	if (size < sizeof(Header)) {
+		ERROR("Invalid embedded curve store.");
+	}
+	attach(data, size, "embedded curve store");
+}
+
+void CurveStore::attach(char const* base, std::size_t size, std::string const& name)
+{
+	header = reinterpret_cast<Header const*>(base);
+	if (std::memcmp(header->magic, magic, sizeof(header->magic)) != 0) {
+		ERROR("Not a curve store: " << name);
+	}
+	if (header->version != version || header->distance_size != sizeof(distance_t)) {
+		ERROR("Incompatible curve store version in " << name << " (version "
+			<< header->version << ", distance size " << header->distance_size << ")");
+	}
+	if (header->file_size != size) {
+		ERROR("Truncated curve store: " << name);
+	}
+
+	// the header is not trusted, i.e., all sections have to lie within the
+	// data and all offsets within their sections
+	auto const num_curves = header->num_curves;
+	auto const num_points = header->num_points;
+	auto fits = [&](uint64_t pos, uint64_t count, uint64_t element_size) {
+		return pos % alignment == 0 && pos <= size && count <= (size - pos)/element_size;
+	};
+	if (num_curves >= size || num_points >= size ||
+	    !fits(header->offsets_pos, num_curves + 1, sizeof(uint64_t)) ||
+	    !fits(header->sizes_pos, num_curves, sizeof(uint64_t)) ||
+	    !fits(header->extreme_points_pos, num_curves, sizeof(Curve::ExtremePoints)) ||
+	    !fits(header->x_pos, num_points, sizeof(distance_t)) ||
+	    !fits(header->y_pos, num_points, sizeof(distance_t)) ||
+	    !fits(header->prefix_lengths_pos, num_points, sizeof(distance_t)) ||
+	    !fits(header->name_offsets_pos, num_curves + 1, sizeof(uint64_t)) ||
+	    !fits(header->names_pos, 0, 1)) {
+		ERROR("Invalid curve store (sections out of bounds): " << name);
+	}
+
+	offsets = reinterpret_cast<uint64_t const*>(base + header->offsets_pos);
+	sizes = reinterpret_cast<uint64_t const*>(base + header->sizes_pos);
+	extreme_points = reinterpret_cast<Curve::ExtremePoints const*>(base + header->extreme_points_pos);
+	xs = reinterpret_cast<distance_t const*>(base + header->x_pos);
+	ys = reinterpret_cast<distance_t const*>(base + header->y_pos);
+	prefix_lengths = reinterpret_cast<distance_t const*>(base + header->prefix_lengths_pos);
+	name_offsets = reinterpret_cast<uint64_t const*>(base + header->name_offsets_pos);
+	names = base + header->names_pos;
+
+	// each curve has to fit into its padded range of points, and each name
+	// into the names
+	auto const names_size = size - header->names_pos;
+	if (offsets[0] != 0 || name_offsets[0] != 0) {
+		ERROR("Invalid curve store (offsets do not start at 0): " << name);
+	}
+	for (uint64_t i = 0; i < num_curves; ++i) {
+		if (offsets[i+1] < offsets[i] || offsets[i+1] > num_points || sizes[i] > offsets[i+1] - offsets[i] ||
+		    name_offsets[i+1] < name_offsets[i] || name_offsets[i+1] > names_size) {
+			ERROR("Invalid curve store (offsets of curve " << i << " out of bounds): " << name);
+		}
+	}
+}
+
+void CurveStore::close()
+{
+	if (mapping != nullptr) {
+		munmap(mapping, mapping_size);
+	}
+
+	mapping = nullptr;
+	mapping_size = 0;
+	header = nullptr;
+}
+
+Curve CurveStore::getCurve(std::size_t index) const
+{
+	assert(is_open() && index < size());
+
+	auto begin = offsets[index];
+	Curve curve(xs + begin, ys + begin, prefix_lengths + begin, sizes[index], extreme_points[index]);
+	curve.filename.assign(names + name_offsets[index], names + name_offsets[index + 1]);
+
+	return curve;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "defs.h"
+#include "geometry_basics.h"
+#include "curves.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace unit_tests { void testCurveStore(); }
+
+// Packed binary container for a whole data set of curves. The file is
+// memory-mapped and the curves returned by getCurve() are views on the
+// mapped data, i.e., loading a store does not copy or parse any coordinates.
+//
+// The coordinates are stored in the same padded structure-of-arrays layout as
+// in Curve, i.e., every curve starts at a cache line and is padded to a
+// multiple of Curve::padding entries by repeating its last point.
+//
+// File layout (all sections 64-byte aligned):
+//   Header
+//   uint64_t point_offsets[num_curves+1]    -- first (padded) entry of each curve
+//   uint64_t sizes[num_curves]              -- number of points of each curve
+//   ExtremePoints extreme_points[num_curves]
+//   distance_t x[num_points]                -- all curves, contiguously
+//   distance_t y[num_points]
+//   distance_t prefix_lengths[num_points]   -- per curve, starting at 0
+//   uint64_t name_offsets[num_curves+1]
+//   char names[]                            -- curve filenames, not terminated
+class CurveStore
+{
+public:
+	static constexpr char const* magic = "FRCURVES";
+	static constexpr uint32_t version = 2;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t distance_size; // sizeof(distance_t) of the writer
+		uint64_t num_curves;
+		uint64_t num_points; // including padding
+		uint64_t offsets_pos;
+		uint64_t sizes_pos;
+		uint64_t extreme_points_pos;
+		uint64_t x_pos;
+		uint64_t y_pos;
+		uint64_t prefix_lengths_pos;
+		uint64_t name_offsets_pos;
+		uint64_t names_pos;
+		uint64_t file_size;
+	};
+
+	CurveStore() = default;
+	~CurveStore();
+	CurveStore(CurveStore const&) = delete;
+	CurveStore& operator=(CurveStore const&) = delete;
+
+	// Checks the magic number at the beginning of the file.
+	static bool isCurveStore(std::string const& filename);
+	static void write(std::string const& filename, Curves const& curves);
+	// writes the store at the current position of the stream, which has to
+	// be a multiple of the alignment of the sections
+	static void write(std::ostream& file, Curves const& curves);
+
+	void open(std::string const& filename);
+	// uses a store which is already in memory, e.g., a section of another
+	// mapped file, which has to outlive the store
+	void open(char const* data, std::size_t size);
+	void close();
+	bool is_open() const { return header != nullptr; }
+
+	std::size_t size() const { return header->num_curves; }
+	Curve getCurve(std::size_t index) const;
+
+private:
+	void* mapping = nullptr;
+	std::size_t mapping_size = 0;
+
+	// sets the pointers to the sections of the store at base
+	void attach(char const* base, std::size_t size, std::string const& name);
+
+	Header const* header = nullptr;
+	uint64_t const* offsets = nullptr;
+	uint64_t const* sizes = nullptr;
+	Curve::ExtremePoints const* extreme_points = nullptr;
+	distance_t const* xs = nullptr;
+	distance_t const* ys = nullptr;
+	distance_t const* prefix_lengths = nullptr;
+	uint64_t const* name_offsets = nullptr;
+	char const* names = nullptr;
+};
@@ -0,0 +1,159 @@
+#include "distance_matrix.h"
+
+#include "frechet_light.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+
+// The distances the triangle inequality is applied to are only approximate,
+// so the bracket is widened by this amount relative to its upper end, and by
+// the absolute error of the bisection of both distances.
+constexpr distance_t bracket_slack = 1e-6;
+constexpr distance_t bracket_absolute_slack = 2*FrechetLight::eps;
+
+} // end anonymous namespace
+
+constexpr char const* DistanceMatrix::magic;
+constexpr uint32_t DistanceMatrix::version;
+
+void DistanceMatrix::compute(Curves const& curves, std::size_t band)
+{
+	initRows(curves.size(), band);
+	auto const effective_band = effectiveBand();
+
+#ifdef WITH_OPENMP
+	std::vector<FrechetLight> frechets(omp_get_max_threads());
+#else
+	std::vector<FrechetLight> frechets(1);
+#endif
+	auto get_frechet = [&]() -> FrechetLight& {
+#ifdef WITH_OPENMP
+		return frechets[omp_get_thread_num()];
+#else
+		return frechets[0];
+#endif
+	};
+
+	if (effective_band == 0) { return; }
+
+	// neighboring curves first, as they are needed for the brackets of the
+	// other pairs
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for (std::size_t i = 0; i < num_curves-1; ++i) {
+		distances[index(i, i+1)] = get_frechet().calcDistance(curves[i], curves[i+1]);
+	}
+
+	// The rows have different lengths in a matrix of all pairs, so they are
+	// scheduled dynamically. Within a row, the bracket of (i,j) uses (i,j-1).
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (std::size_t i = 0; i < num_curves; ++i) {
+		auto& frechet = get_frechet();
+		auto const end = std::min(num_curves, i + effective_band + 1);
+		for (std::size_t j = i+2; j < end; ++j) {
+			auto const distance1 = distances[index(i, j-1)];
+			auto const distance2 = distances[index(j-1, j)];
+			auto const slack = bracket_slack*(distance1 + distance2) + bracket_absolute_slack;
+			auto const min = std::abs(distance1 - distance2) - slack;
+			auto const max = distance1 + distance2 + slack;
+			distances[index(i, j)] = frechet.calcDistance(curves[i], curves[j], min, max);
+		}
+	}
+}
+
+bool DistanceMatrix::contains(std::size_t i, std::size_t j) const
+{
+	if (i > j) { std::swap(i, j); }
+	return j < num_curves && j - i <= effectiveBand();
+}
+
+distance_t DistanceMatrix::get(std::size_t i, std::size_t j) const
+{
+	assert(contains(i, j));
+
+	if (i == j) { return 0; }
+	if (i > j) { std::swap(i, j); }
+	return distances[index(i, j)];
+}
+
+void DistanceMatrix::write(std::string const& filename) const
+{
+	Header header;
+	std::memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = version;
+	header.distance_size = sizeof(distance_t);
+	header.num_curves = num_curves;
+	header.band = band;
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		ERROR("Could not open distance matrix for writing: " << filename);
+	}
+
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.write(reinterpret_cast<char const*>(distances.data()), distances.size()*sizeof(distance_t));
+
+	if (!file) {
+		ERROR("Error while writing distance matrix: " << filename);
+	}
+}
+
+void DistanceMatrix::read(std::string const& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		ERROR("Could not open distance matrix: " << filename);
+	}
+
+	Header header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+	    std::memcmp(header.magic, magic, sizeof(header.magic)) != 0) {
+		ERROR("Not a distance matrix: " << filename);
+	}
+	if (header.version != version || header.distance_size != sizeof(distance_t)) {
+		ERROR("Incompatible distance matrix version in " << filename << " (version "
+			<< header.version << ", distance size " << header.distance_size << ")");
+	}
+
+	initRows(header.num_curves, header.band);
+	if (!file.read(reinterpret_cast<char*>(distances.data()), distances.size()*sizeof(distance_t))) {
+		ERROR("Truncated distance matrix: " << filename);
+	}
+}
+
+std::size_t DistanceMatrix::effectiveBand() const
+{
+	if (num_curves == 0) { return 0; }
+	return (band == 0 || band > num_curves-1) ? num_curves-1 : band;
+}
+
+void DistanceMatrix::initRows(std::size_t num_curves, std::size_t band)
+{
+	this->num_curves = num_curves;
+	this->band = band;
+
+	auto const effective_band = effectiveBand();
+	row_offsets.assign(1, 0);
+	for (std::size_t i = 0; i < num_curves; ++i) {
+		row_offsets.push_back(row_offsets.back() + std::min(effective_band, num_curves-1 - i));
+	}
+	distances.assign(row_offsets.back(), 0);
+}
+
+std::size_t DistanceMatrix::index(std::size_t i, std::size_t j) const
+{
+	assert(i < j && j - i <= effectiveBand());
+	return row_offsets[i] + (j - i - 1);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "defs.h"
+#include "geometry_basics.h"
+#include "curves.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace unit_tests { void testDistanceMatrix(); }
+
+// Frechet distances of all pairs of a set of curves, or only of the pairs
+// (i,j) with |i-j| <= band, e.g., for curves which are ordered in time. As the
+// Frechet distance is symmetric, only the pairs i < j are computed and stored.
+//
+// The rows are computed in parallel, each thread with its own FrechetLight.
+// The pairs of neighboring curves are computed first, such that the bisection
+// for a pair (i,j) can start from the bracket given by the triangle inequality
+// |d(i,j-1) - d(j-1,j)| <= d(i,j) <= d(i,j-1) + d(j-1,j).
+//
+// File layout:
+//   Header
+//   distance_t distances[]  -- row by row, i.e., (0,1), (0,2), ..., (1,2), ...
+class DistanceMatrix
+{
+public:
+	static constexpr char const* magic = "FRDISTMX";
+	static constexpr uint32_t version = 1;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t distance_size; // sizeof(distance_t) of the writer
+		uint64_t num_curves;
+		uint64_t band;
+	};
+
+	DistanceMatrix() = default;
+
+	// band 0 means all pairs
+	void compute(Curves const& curves, std::size_t band = 0);
+
+	std::size_t size() const { return num_curves; }
+	std::size_t getBand() const { return band; }
+	// whether the distance of the pair is stored (or trivially 0 for i == j)
+	bool contains(std::size_t i, std::size_t j) const;
+	distance_t get(std::size_t i, std::size_t j) const;
+
+	void write(std::string const& filename) const;
+	void read(std::string const& filename);
+
+private:
+	std::size_t num_curves = 0;
+	std::size_t band = 0;
+	std::vector<distance_t> distances;
+	// first entry of each row
+	std::vector<std::size_t> row_offsets;
+
+	// the band of a matrix of all pairs is num_curves-1
+	std::size_t effectiveBand() const;
+	void initRows(std::size_t num_curves, std::size_t band);
+	std::size_t index(std::size_t i, std::size_t j) const;
+};
@@ -0,0 +1,365 @@
+#pragma once
+
+#include "kdtree.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace unit_tests { void testDynamicKdTree(); }
+
+// A KdTree which can be updated after it was built, by the logarithmic
+// method: inserted points are collected in a small buffer which is scanned
+// linearly. A full buffer is merged with the smallest static trees while they
+// are not larger than the points merged so far, like the carry of a binary
+// counter. Thus, there are O(log n) trees and each point is rebuilt O(log n)
+// times. Removed points are marked by tombstones, which are dropped when their
+// tree is merged, or by a rebuild once they make up half of the points.
+//
+// The values have to be unique and a removed value must not be added again.
+template <typename T, int k, typename V, typename D = T, typename N = PointwiseNear<std::array<T, k>, D>>
+class DynamicKdTree
+{
+public:
+	using StaticTree = KdTree<T, k, V, D, N>;
+	using Point = typename StaticTree::Point;
+	using Value = V;
+	using Values = std::vector<Value>;
+	using Distance = D;
+	using NearChecker = N;
+	using PointDistance = typename StaticTree::PointDistance;
+	using Layout = typename StaticTree::Layout;
+	using Data = typename StaticTree::Data;
+
+	// number of inserted points after which the buffer is merged into the trees
+	static constexpr std::size_t buffer_size = 64;
+
+	DynamicKdTree(NearChecker const& near_checker)
+		: is_near(near_checker), buffer_coordinates(k*buffer_size) {}
+	DynamicKdTree(NearChecker const& near_checker, PointDistance const& point_distance)
+		: is_near(near_checker), point_distance(point_distance), buffer_coordinates(k*buffer_size) {}
+
+	// Before the first build the points are only collected, like for a
+	// KdTree. Afterwards, they can be searched immediately.
+	void add(Point const& point, Value value);
+	void remove(Value value);
+	// merges all points into a single tree
+	void build(Layout layout = Layout::Heap);
+	void clear();
+
+	// the number of points which were not removed
+	std::size_t size() const;
+
+	// the arrays of the single tree after build(), see KdTree::Data
+	Data getData() const;
+	// replaces the points by the ones of a built KdTree
+	void assign(Data const& data);
+
+	// Fills the variable 'result' by all the points in the kdtree
+	// which are <= 'distance' away from 'point'
+	void search(Point const& point, Distance distance, Values& result) const;
+
+	class BestFirstSearch;
+
+private:
+	bool is_ready_for_search = false;
+	NearChecker is_near;
+	PointDistance point_distance;
+	Layout layout = Layout::Heap;
+
+	using PointValues = std::vector<std::pair<Point, Value>>;
+
+	struct Level
+	{
+		StaticTree tree;
+		std::size_t size; // including the removed points
+	};
+	// by decreasing size
+	std::vector<Level> levels;
+	std::size_t num_level_points = 0;
+	// the removed points of the levels
+	std::unordered_set<Value> tombstones;
+
+	// the points added before the first build
+	PointValues pending;
+	// the points inserted since the last merge, in structure of arrays form
+	// with stride buffer_size (see NearChecker)
+	std::vector<T> buffer_coordinates;
+	Values buffer_values;
+
+	// merges the levels starting at first_level together with the points
+	void mergeLevels(std::size_t first_level, PointValues& points);
+	void flushBuffer();
+	Point getBufferPoint(std::size_t i) const;
+};
+
+template <typename T, int k, typename V, typename D, typename N>
+constexpr std::size_t DynamicKdTree<T, k, V, D, N>::buffer_size;
+
+// Merges the BestFirstSearch of all levels and the buffer, see
+// KdTree::BestFirstSearch. The tree must not be changed during the search.
+template <typename T, int k, typename V, typename D, typename N>
+class DynamicKdTree<T, k, V, D, N>::BestFirstSearch
+{
+public:
+	BestFirstSearch(DynamicKdTree const& kd_tree, Point const& query_point,
+		Distance max_distance = std::numeric_limits<Distance>::max());
+
+	// Returns false if there is no further point within max_distance.
+	// Otherwise, sets value and distance of the next point.
+	bool next(Value& value, Distance& distance);
+
+private:
+	// the next point of a source, i.e., of a level or (if source is the
+	// number of levels) of the buffer
+	struct Element
+	{
+		Distance distance;
+		Value value;
+		std::size_t source;
+
+		bool operator>(Element const& other) const { return distance > other.distance; }
+	};
+
+	DynamicKdTree const& kd_tree;
+	std::vector<typename StaticTree::BestFirstSearch> searches;
+	// the points of the buffer within max_distance, by decreasing distance
+	std::vector<std::pair<Distance, Value>> buffer_points;
+	std::priority_queue<Element, std::vector<Element>, std::greater<Element>> queue;
+
+	void advance(std::size_t source);
+};
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::add(Point const& point, Value value)
+{
+	if (!is_ready_for_search) {
+		pending.emplace_back(point, value);
+		return;
+	}
+
+	auto const i = buffer_values.size();
+	for (std::size_t d = 0; d < k; ++d) {
+		buffer_coordinates[d*buffer_size + i] = point[d];
+	}
+	buffer_values.push_back(value);
+
+	if (buffer_values.size() == buffer_size) {
+		flushBuffer();
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::remove(Value value)
+{
+	assert(is_ready_for_search);
+
+	// points of the buffer are removed directly
+	auto it = std::find(buffer_values.begin(), buffer_values.end(), value);
+	if (it != buffer_values.end()) {
+		auto const i = std::distance(buffer_values.begin(), it);
+		auto const last = buffer_values.size() - 1;
+		for (std::size_t d = 0; d < k; ++d) {
+			buffer_coordinates[d*buffer_size + i] = buffer_coordinates[d*buffer_size + last];
+		}
+		buffer_values[i] = buffer_values[last];
+		buffer_values.pop_back();
+		return;
+	}
+
+	assert(tombstones.count(value) == 0);
+	tombstones.insert(value);
+	if (2*tombstones.size() > num_level_points) {
+		PointValues points;
+		mergeLevels(0, points);
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::build(Layout layout)
+{
+	this->layout = layout;
+
+	PointValues points;
+	points.swap(pending);
+	for (std::size_t i = 0; i < buffer_values.size(); ++i) {
+		points.emplace_back(getBufferPoint(i), buffer_values[i]);
+	}
+	buffer_values.clear();
+	mergeLevels(0, points);
+
+	is_ready_for_search = true;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::clear()
+{
+	levels.clear();
+	num_level_points = 0;
+	tombstones.clear();
+	pending.clear();
+	buffer_values.clear();
+	is_ready_for_search = false;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+std::size_t DynamicKdTree<T, k, V, D, N>::size() const
+{
+	return pending.size() + buffer_values.size() + num_level_points - tombstones.size();
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+auto DynamicKdTree<T, k, V, D, N>::getData() const -> Data
+{
+	assert(is_ready_for_search && levels.size() <= 1);
+	assert(pending.empty() && buffer_values.empty() && tombstones.empty());
+
+	return levels.empty() ? Data() : levels.front().tree.getData();
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::assign(Data const& data)
+{
+	clear();
+
+	if (data.num_points > 0) {
+		levels.push_back({StaticTree(is_near, point_distance), data.num_points});
+		levels.back().tree.assign(data);
+		num_level_points = data.num_points;
+	}
+
+	is_ready_for_search = true;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::search(Point const& query_point, Distance distance, Values& result) const
+{
+	assert(is_ready_for_search);
+
+	auto const first_result = result.size();
+	for (auto const& level: levels) {
+		level.tree.search(query_point, distance, result);
+	}
+	if (!tombstones.empty()) {
+		auto is_removed = [&](Value value) { return tombstones.count(value) != 0; };
+		result.erase(std::remove_if(result.begin() + first_result, result.end(), is_removed), result.end());
+	}
+
+	is_near.scan(buffer_coordinates.data(), buffer_size, buffer_values.size(), query_point, distance,
+		[&](std::size_t i) { result.push_back(buffer_values[i]); });
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::mergeLevels(std::size_t first_level, PointValues& points)
+{
+	for (auto level = first_level; level < levels.size(); ++level) {
+		levels[level].tree.forEachPoint([&](Point const& point, Value value) {
+			if (tombstones.erase(value) == 0) { points.emplace_back(point, value); }
+		});
+		num_level_points -= levels[level].size;
+	}
+	levels.erase(levels.begin() + first_level, levels.end());
+
+	if (points.empty()) { return; }
+
+	levels.push_back({StaticTree(is_near, point_distance), points.size()});
+	auto& tree = levels.back().tree;
+	for (auto const& point: points) {
+		tree.add(point.first, point.second);
+	}
+	tree.build(layout);
+	num_level_points += points.size();
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::flushBuffer()
+{
+	PointValues points;
+	for (std::size_t i = 0; i < buffer_values.size(); ++i) {
+		points.emplace_back(getBufferPoint(i), buffer_values[i]);
+	}
+	buffer_values.clear();
+
+	// merge the smallest levels while they are not larger than the points
+	// merged so far, which keeps the levels sorted by decreasing size
+	auto first_level = levels.size();
+	auto merged_size = points.size();
+	while (first_level > 0 && levels[first_level - 1].size <= merged_size) {
+		--first_level;
+		merged_size += levels[first_level].size;
+	}
+	mergeLevels(first_level, points);
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+auto DynamicKdTree<T, k, V, D, N>::getBufferPoint(std::size_t i) const -> Point
+{
+	Point point;
+	for (std::size_t d = 0; d < k; ++d) {
+		point[d] = buffer_coordinates[d*buffer_size + i];
+	}
+	return point;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+DynamicKdTree<T, k, V, D, N>::BestFirstSearch::BestFirstSearch(DynamicKdTree const& kd_tree, Point const& query_point, Distance max_distance)
+	: kd_tree(kd_tree)
+{
+	assert(kd_tree.is_ready_for_search);
+	assert(kd_tree.point_distance);
+
+	searches.reserve(kd_tree.levels.size());
+	for (auto const& level: kd_tree.levels) {
+		searches.emplace_back(level.tree, query_point, max_distance);
+	}
+
+	for (std::size_t i = 0; i < kd_tree.buffer_values.size(); ++i) {
+		auto const distance = kd_tree.point_distance(kd_tree.getBufferPoint(i), query_point);
+		if (distance <= max_distance) {
+			buffer_points.emplace_back(distance, kd_tree.buffer_values[i]);
+		}
+	}
+	std::sort(buffer_points.begin(), buffer_points.end(),
+		[](std::pair<Distance, Value> const& a, std::pair<Distance, Value> const& b) { return a.first > b.first; });
+
+	for (std::size_t source = 0; source <= searches.size(); ++source) {
+		advance(source);
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+bool DynamicKdTree<T, k, V, D, N>::BestFirstSearch::next(Value& value, Distance& distance)
+{
+	if (queue.empty()) { return false; }
+
+	auto const current = queue.top();
+	queue.pop();
+	value = current.value;
+	distance = current.distance;
+	advance(current.source);
+
+	return true;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void DynamicKdTree<T, k, V, D, N>::BestFirstSearch::advance(std::size_t source)
+{
+	if (source < searches.size()) {
+		Value value;
+		Distance distance;
+		while (searches[source].next(value, distance)) {
+			if (kd_tree.tombstones.count(value) == 0) {
+				queue.push({distance, value, source});
+				return;
+			}
+		}
+	}
+	else if (!buffer_points.empty()) {
+		queue.push({buffer_points.back().first, buffer_points.back().second, source});
+		buffer_points.pop_back();
+	}
+}
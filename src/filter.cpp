@@ -1,5 +1,68 @@
 #include "filter.h"
 
+#include <algorithm>
+
+namespace
+{
+
+distance_t distanceToCurveSqr(Point const& point, Curve const& curve)
+{
+	auto dist_sqr = point.dist_sqr(curve.front());
+	for (PointID i = 0; i+1 < curve.size(); ++i) {
+		dist_sqr = std::min(dist_sqr, segmentDistanceSqr(point, curve[i], curve[i+1]));
+	}
+	return dist_sqr;
+}
+
+} // end anonymous namespace
+
+distance_t Filter::lowerBound(Curve const& curve1, Curve const& curve2)
+{
+	auto dist_sqr = std::max(curve1.front().dist_sqr(curve2.front()), curve1.back().dist_sqr(curve2.back()));
+	for (size_t step = 1; step <= curve1.size(); increase(step)) {
+		dist_sqr = std::max(dist_sqr, distanceToCurveSqr(curve1[step-1], curve2));
+	}
+	for (size_t step = 1; step <= curve2.size(); increase(step)) {
+		dist_sqr = std::max(dist_sqr, distanceToCurveSqr(curve2[step-1], curve1));
+	}
+	return std::sqrt(dist_sqr);
+}
+
+distance_t Filter::upperBound(Curve const& curve1, Curve const& curve2)
+{
+	auto d_sqr = curve1.back().dist_sqr(curve2.back());
+	PointID pos1 = 0;
+	PointID pos2 = 0;
+
+	// same traversal as in greedy
+	while (pos1 + pos2 < curve1.size() + curve2.size() - 2) {
+		d_sqr = std::max(d_sqr, curve1[pos1].dist_sqr(curve2[pos2]));
+
+		if (curve1.size() - 1 == pos1) {
+			++pos2;
+		}
+		else if (curve2.size() - 1 == pos2) {
+			++pos1;
+		}
+		else {
+			distance_t dist1 = curve1[pos1 + 1].dist_sqr(curve2[pos2]);
+			distance_t dist2 = curve1[pos1].dist_sqr(curve2[pos2 + 1]);
+			distance_t dist12 = curve1[pos1 + 1].dist_sqr(curve2[pos2 + 1]);
+
+			if (dist1 < dist2 && dist1 < dist12) {
+				++pos1;
+			} else if (dist2 < dist12) {
+				++pos2;
+			} else {
+				++pos1;
+				++pos2;
+			}
+		}
+	}
+
+	return std::min(std::sqrt(d_sqr), curve1.getUpperBoundDistance(curve2));
+}
+
 bool Filter::isPointTooFarFromCurve(Point fixed, const Curve& curve, distance_t distance)
 {
 	auto dist_sqr = distance * distance;
@@ -35,6 +98,12 @@ bool Filter::isFree(Point const& fixed, Curve const& var_curve, PointID start, P
 	if (comp_dist > 0 && mid_dist_sqr <= std::pow(comp_dist, 2)) {
 		return true;
 	}
+	// For short ranges, checking all points is cheap (it's vectorized) and
+	// exact: by convexity of the disk, the segments between the points are
+	// within distance as well.
+	else if (end - start < exact_free_check_size) {
+		return var_curve.allPointsWithin(fixed, start, end, distance*distance);
+	}
 	else {
 		return false;
 	}
@@ -12,6 +12,9 @@ private:
 	const Curve *curve1_pt, *curve2_pt;
 	distance_t distance;
 
+	// isFree checks ranges of fewer points exactly
+	static constexpr std::size_t exact_free_check_size = 4*Curve::padding;
+
 public:
 	Filter(const Curve& curve1, const Curve& curve2, distance_t distance) {
 		this->curve1_pt = &curve1;
@@ -31,6 +34,13 @@ public:
 	bool adaptiveSimultaneousGreedy();
 	bool negative(PointID pos1, PointID pos2);
 
+	// Cheap bounds on the Frechet distance, e.g., to start a search for it.
+	// The lower bound is the maximum of the endpoint distances and of the
+	// distances of the points checked by negative to the other curve. The
+	// upper bound is the maximum distance along the traversal of greedy.
+	static distance_t lowerBound(Curve const& curve1, Curve const& curve2);
+	static distance_t upperBound(Curve const& curve1, Curve const& curve2);
+
 	static bool isPointTooFarFromCurve(Point fixed, const Curve& curve, distance_t distance);
 	static bool isFree(Point const& fixed, Curve const& var_curve, PointID start, PointID end,
 	                   distance_t distance);
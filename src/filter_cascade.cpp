@@ -0,0 +1,196 @@
+#include "filter_cascade.h"
+
+#include "times.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+
+namespace
+{
+
+// stages with fewer timed calls in the window are ranked by all calls
+constexpr std::size_t min_timed_calls = 8;
+
+} // end anonymous namespace
+
+constexpr std::size_t FilterCascade::num_stages;
+constexpr std::size_t FilterCascade::timing_interval;
+constexpr std::size_t FilterCascade::reorder_interval;
+
+auto FilterCascade::defaultOrder() -> Order
+{
+	return {{Stage::BichromaticFarthestDistance, Stage::Greedy, Stage::Negative, Stage::SimultaneousGreedy}};
+}
+
+std::string FilterCascade::getName(Stage stage)
+{
+	switch (stage) {
+	case Stage::BichromaticFarthestDistance: return "bichromatic farthest distance";
+	case Stage::Greedy: return "greedy";
+	case Stage::Negative: return "negative";
+	case Stage::SimultaneousGreedy: return "simultaneous greedy";
+	}
+	return "";
+}
+
+FilterCascade::FilterCascade(bool record_times)
+	: order(defaultOrder()), record_times(record_times)
+{
+}
+
+void FilterCascade::setOrder(Order const& order)
+{
+	for (std::size_t i = 0; i < num_stages; ++i) {
+		if (std::count(order.begin(), order.end(), static_cast<Stage>(i)) != 1) {
+			ERROR("Each filter stage has to occur exactly once in the order.");
+		}
+	}
+
+	this->order = order;
+}
+
+void FilterCascade::setAdaptive(bool adaptive)
+{
+	this->adaptive = adaptive;
+}
+
+auto FilterCascade::decide(Filter& filter, Stage& deciding_stage) -> Decision
+{
+	bool const is_timed = (num_decisions % timing_interval == 0);
+	++num_decisions;
+
+	auto decision = Decision::Undecided;
+	PointID pos1 = 0;
+	PointID pos2 = 0;
+	for (auto stage: order) {
+		auto& stage_statistics = window[static_cast<std::size_t>(stage)];
+		++stage_statistics.calls;
+
+		bool is_hit;
+		if (is_timed) {
+			auto const start = std::chrono::steady_clock::now();
+			is_hit = runStage(stage, filter, pos1, pos2);
+			stage_statistics.time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			++stage_statistics.timed_calls;
+		}
+		else {
+			is_hit = runStage(stage, filter, pos1, pos2);
+		}
+
+		if (is_hit) {
+			++stage_statistics.hits;
+			deciding_stage = stage;
+			decision = (stage == Stage::Negative) ? Decision::No : Decision::Yes;
+			break;
+		}
+	}
+
+	if (num_decisions % reorder_interval == 0) {
+		finishWindow();
+	}
+
+	return decision;
+}
+
+auto FilterCascade::getStatistics() const -> Statistics
+{
+	auto sum = statistics;
+	add(sum, window);
+	return sum;
+}
+
+void FilterCascade::resetStatistics()
+{
+	statistics = Statistics();
+	window = Statistics();
+	num_decisions = 0;
+}
+
+void FilterCascade::add(Statistics& sum, Statistics const& statistics)
+{
+	for (std::size_t i = 0; i < num_stages; ++i) {
+		sum[i].calls += statistics[i].calls;
+		sum[i].hits += statistics[i].hits;
+		sum[i].timed_calls += statistics[i].timed_calls;
+		sum[i].time += statistics[i].time;
+	}
+}
+
+void FilterCascade::print(std::ostream& out, Statistics const& statistics)
+{
+	out << "Filter stage statistics:\n";
+	for (std::size_t i = 0; i < num_stages; ++i) {
+		auto const& stage_statistics = statistics[i];
+		out << std::setw(30) << std::left << getName(static_cast<Stage>(i)) << std::right
+			<< " calls: " << std::setw(10) << stage_statistics.calls
+			<< " hits: " << std::setw(10) << stage_statistics.hits
+			<< " hit rate: " << std::setw(8) << std::setprecision(3) << stage_statistics.hitRate()
+			<< " mean time: " << std::setw(8) << std::setprecision(3) << stage_statistics.meanTime()*1e6 << " us\n";
+	}
+}
+
+bool FilterCascade::runStage(Stage stage, Filter& filter, PointID& pos1, PointID& pos2)
+{
+	bool is_hit = false;
+
+	switch (stage) {
+	case Stage::BichromaticFarthestDistance:
+		is_hit = filter.bichromaticFarthestDistance();
+		break;
+	case Stage::Greedy:
+		if (record_times) {
+			global::times.startGreedy();
+			global::times.startCountingGreedySteps();
+		}
+		is_hit = filter.adaptiveGreedy(pos1, pos2);
+		if (record_times) {
+			global::times.stopGreedy();
+			global::times.stopCountingGreedySteps();
+		}
+		break;
+	case Stage::Negative:
+		if (record_times) { global::times.startNegative(); }
+		is_hit = filter.negative(pos1, pos2);
+		if (record_times) { global::times.stopNegative(); }
+		break;
+	case Stage::SimultaneousGreedy:
+		if (record_times) { global::times.startSimultaneousGreedy(); }
+		is_hit = filter.adaptiveSimultaneousGreedy();
+		if (record_times) { global::times.stopSimultaneousGreedy(); }
+		break;
+	}
+
+	return is_hit;
+}
+
+void FilterCascade::finishWindow()
+{
+	add(statistics, window);
+
+	if (adaptive) {
+		// Expected cost per hit, where stages without hits come last. Stages
+		// which were never timed (as the stages before them decided all
+		// candidates) come first, such that they are explored.
+		std::array<double, num_stages> ranks;
+		for (std::size_t i = 0; i < num_stages; ++i) {
+			auto const& stage_statistics = (window[i].timed_calls >= min_timed_calls) ? window[i] : statistics[i];
+			if (stage_statistics.timed_calls == 0) {
+				ranks[i] = 0.;
+			}
+			else if (stage_statistics.hits == 0) {
+				ranks[i] = std::numeric_limits<double>::infinity();
+			}
+			else {
+				ranks[i] = stage_statistics.meanTime()/stage_statistics.hitRate();
+			}
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&](Stage stage1, Stage stage2) {
+			return ranks[static_cast<std::size_t>(stage1)] < ranks[static_cast<std::size_t>(stage2)];
+		});
+	}
+
+	window = Statistics();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "defs.h"
+#include "filter.h"
+
+#include <array>
+#include <ostream>
+#include <string>
+
+namespace unit_tests { void testFilterCascade(); }
+
+// The filters which decide a candidate of a query before the exact decider,
+// as a pipeline of stages. Each stage counts how often it is called and how
+// often it decides (a hit), and the time of every timing_interval-th call.
+//
+// If the cascade is adaptive (the default), the stages are reordered after each window of
+// reorder_interval decisions by their expected cost per hit, i.e., by their
+// mean time divided by their hit rate in the window, which is the optimal
+// order if the stages decide independently of each other. The hit rates
+// depend on the data set and on the query distance, which is why only the
+// recent window is used. Stages which were never timed are tried first.
+//
+// Negative starts at the positions where Greedy got stuck if Greedy ran
+// before it, and at the start of the curves otherwise.
+class FilterCascade
+{
+public:
+	enum class Stage { BichromaticFarthestDistance, Greedy, Negative, SimultaneousGreedy };
+	static constexpr std::size_t num_stages = 4;
+	using Order = std::array<Stage, num_stages>;
+
+	// undecided candidates have to be checked by the exact decider
+	enum class Decision { Undecided, Yes, No };
+
+	struct StageStatistics
+	{
+		std::size_t calls = 0;
+		std::size_t hits = 0;
+		std::size_t timed_calls = 0;
+		double time = 0.; // in seconds, of the timed calls
+
+		double meanTime() const { return timed_calls ? time/timed_calls : 0.; }
+		double hitRate() const { return calls ? double(hits)/calls : 0.; }
+	};
+	// indexed by the stages
+	using Statistics = std::array<StageStatistics, num_stages>;
+
+	static constexpr std::size_t timing_interval = 8;
+	static constexpr std::size_t reorder_interval = 1024;
+
+	// bichromatic farthest distance, greedy, negative, simultaneous greedy
+	static Order defaultOrder();
+	static std::string getName(Stage stage);
+
+	// If record_times is set, the stages are also recorded in global::times,
+	// which is not thread-safe.
+	FilterCascade(bool record_times = false);
+
+	void setOrder(Order const& order);
+	Order const& getOrder() const { return order; }
+	void setAdaptive(bool adaptive);
+	bool isAdaptive() const { return adaptive; }
+
+	// Runs the stages in the current order until one of them decides, which
+	// is then returned in deciding_stage.
+	Decision decide(Filter& filter, Stage& deciding_stage);
+
+	Statistics getStatistics() const;
+	void resetStatistics();
+	static void add(Statistics& sum, Statistics const& statistics);
+	static void print(std::ostream& out, Statistics const& statistics);
+
+private:
+	Order order;
+	bool adaptive = true;
+	bool record_times;
+
+	Statistics statistics;
+	// the statistics since the last reordering
+	Statistics window;
+	std::size_t num_decisions = 0;
+
+	bool runStage(Stage stage, Filter& filter, PointID& pos1, PointID& pos2);
+	// adds the window to the statistics and reorders the stages by it
+	void finishWindow();
+};
@@ -6,6 +6,164 @@
 
 #include <algorithm>
 
+namespace
+{
+
+// Bounding boxes of consecutive blocks of points. With `segments`, each block
+// also contains the first point of the next block, such that it contains the
+// segments starting at its points.
+std::vector<Curve::ExtremePoints> blockBoxes(Curve const& curve, std::size_t block_size, bool segments)
+{
+	std::vector<Curve::ExtremePoints> boxes;
+	for (PointID begin = 0; begin < curve.size(); begin += block_size) {
+		auto const end = std::min<PointID>(begin + block_size + (segments ? 1 : 0), curve.size());
+		Curve::ExtremePoints box = {curve[begin].x, curve[begin].y, curve[begin].x, curve[begin].y};
+		for (PointID i = begin+1; i < end; ++i) {
+			box.min_x = std::min(box.min_x, curve[i].x);
+			box.min_y = std::min(box.min_y, curve[i].y);
+			box.max_x = std::max(box.max_x, curve[i].x);
+			box.max_y = std::max(box.max_y, curve[i].y);
+		}
+		boxes.push_back(box);
+	}
+	return boxes;
+}
+
+using PointRanges = std::vector<std::pair<PointID, PointID>>;
+
+// Calls f(begin2, end2, ranges1) for each block [begin2, end2) of segments of
+// curve2 with the blocks of points of curve1 of which some distance to these
+// segments might lie in [min, max], i.e., which are not excluded by their
+// bounding boxes.
+template <typename F>
+void forEachSegmentBlock(Curve const& curve1, Curve const& curve2, distance_t min, distance_t max, F f)
+{
+	static constexpr std::size_t block_size = 8;
+
+	auto const boxes1 = blockBoxes(curve1, block_size, false);
+	auto const boxes2 = blockBoxes(curve2, block_size, true);
+	PointRanges ranges1;
+	for (std::size_t b2 = 0; b2 < boxes2.size(); ++b2) {
+		auto const& box2 = boxes2[b2];
+		ranges1.clear();
+		for (std::size_t b1 = 0; b1 < boxes1.size(); ++b1) {
+			auto const& box1 = boxes1[b1];
+			auto const gap_x = std::max<distance_t>({0., box1.min_x - box2.max_x, box2.min_x - box1.max_x});
+			auto const gap_y = std::max<distance_t>({0., box1.min_y - box2.max_y, box2.min_y - box1.max_y});
+			auto const span_x = std::max(box1.max_x - box2.min_x, box2.max_x - box1.min_x);
+			auto const span_y = std::max(box1.max_y - box2.min_y, box2.max_y - box1.min_y);
+			if (gap_x*gap_x + gap_y*gap_y > max*max || (min > 0 && span_x*span_x + span_y*span_y < min*min)) { continue; }
+
+			PointID const begin1 = b1*block_size;
+			ranges1.emplace_back(begin1, std::min<PointID>(begin1 + block_size, curve1.size()));
+		}
+
+		PointID const begin2 = b2*block_size;
+		if (!ranges1.empty()) { f(begin2, std::min<PointID>(begin2 + block_size, curve2.size()-1), ranges1); }
+	}
+}
+
+// Adds the distances of the points of curve1 to the segments of curve2 which
+// lie in (min, max].
+void addPointSegmentDistances(Curve const& curve1, Curve const& curve2,
+	distance_t min, distance_t max, std::vector<distance_t>& values)
+{
+	auto const min_sqr = min*min, max_sqr = max*max;
+	forEachSegmentBlock(curve1, curve2, min, max, [&](PointID begin2, PointID end2, PointRanges const& ranges1) {
+		for (PointID j = begin2; j < end2; ++j) {
+			for (auto const& range: ranges1) {
+				for (PointID i = range.first; i < range.second; ++i) {
+					auto const distance_sqr = segmentDistanceSqr(curve1[i], curve2[j], curve2[j+1]);
+					if (distance_sqr < min_sqr || distance_sqr > max_sqr) { continue; }
+					auto const distance = std::sqrt(distance_sqr);
+					if (min < distance && distance <= max) { values.push_back(distance); }
+				}
+			}
+		}
+	});
+}
+
+// Adds the monotonicity events in (min, max] of two points of curve1 and a
+// segment of curve2, i.e., the distance of the points to the point on the
+// segment which has the same distance to both. Such a point has distance in
+// (min, max) to both points, so only pairs of points are considered for which
+// the parts of the segment at such a distance overlap. For a narrow (min, max)
+// these parts are short and overlap rarely. Returns false if this would take
+// more than `budget` pairs of points.
+bool addMonotonicityEvents(Curve const& curve1, Curve const& curve2,
+	distance_t min, distance_t max, std::vector<distance_t>& values, std::size_t& budget)
+{
+	struct Part {
+		distance_t begin, end;
+		PointID point;
+		bool operator<(Part const& other) const { return begin < other.begin; }
+	};
+	std::vector<Part> parts;
+
+	// some slack such that rounding cannot lose events; the inner radius is
+	// clamped, as min might be close to 0 compared to max
+	auto const slack = max - min;
+	auto const inner_radius = std::max<distance_t>(0., min - slack);
+	auto const outer_radius = max + slack;
+
+	bool within_budget = true;
+	forEachSegmentBlock(curve1, curve2, inner_radius, outer_radius, [&](PointID begin2, PointID end2, PointRanges const& ranges1) {
+		for (PointID j = begin2; within_budget && j < end2; ++j) {
+			auto const start = curve2[j];
+			auto const v = curve2[j+1] - start;
+			auto const length_sqr = v.x*v.x + v.y*v.y;
+			if (length_sqr == 0) { continue; }
+
+			// the parts of the segment (as parameters in [0,1]) where the distance
+			// to a point of curve1 is between the radii
+			parts.clear();
+			for (auto const& range: ranges1) {
+				for (PointID i = range.first; i < range.second; ++i) {
+					auto const w = curve1[i] - start;
+					auto const projection = (w.x*v.x + w.y*v.y)/length_sqr;
+					auto const offset_sqr = (w.x*w.x + w.y*w.y)/length_sqr - projection*projection;
+
+					auto const outer_sqr = outer_radius*outer_radius/length_sqr - offset_sqr;
+					if (outer_sqr < 0) { continue; }
+					auto const outer = std::sqrt(outer_sqr);
+					auto const inner_sqr = inner_radius*inner_radius/length_sqr - offset_sqr;
+					auto const inner = (inner_radius > 0 && inner_sqr > 0) ? std::sqrt(inner_sqr) : distance_t(0);
+
+					for (auto const& part: {Part{projection - outer, projection - inner, i}, Part{projection + inner, projection + outer, i}}) {
+						if (part.end >= 0 && part.begin <= 1) { parts.push_back(part); }
+					}
+				}
+			}
+			std::sort(parts.begin(), parts.end());
+
+			for (std::size_t k = 0; k < parts.size(); ++k) {
+				for (std::size_t l = k+1; l < parts.size() && parts[l].begin <= parts[k].end; ++l) {
+					if (parts[k].point == parts[l].point) { continue; }
+					if (budget == 0) { within_budget = false; return; }
+					--budget;
+
+					// the point start + t*v on the bisector of p and q
+					auto const p = curve1[parts[k].point];
+					auto const q = curve1[parts[l].point];
+					auto const w = q - p;
+					auto const denominator = v.x*w.x + v.y*w.y;
+					if (denominator == 0) { continue; }
+					auto const mid = (p + q)*0.5 - start;
+					auto const t = (mid.x*w.x + mid.y*w.y)/denominator;
+					if (t < 0 || t > 1) { continue; }
+
+					auto const distance = p.dist(start + v*t);
+					if (min < distance && distance <= max) { values.push_back(distance); }
+				}
+			}
+		}
+	});
+
+	return within_budget;
+}
+
+} // end anonymous namespace
+
 void FrechetLight::certSetValues(
 	CInterval& interval, CInterval const& parent, PointID point_id, CurveID curve_id)
 {
@@ -123,7 +281,7 @@ inline CInterval FrechetLight::getInterval(Point const& point, Curve const& curv
     if (outer != nullptr) {
 		//TODO change intersection_interval so that the outer interval is
 		// 0,1 instead of -eps, 1+eps ?
-		*outer = CInterval{i, std::max(outer_temp.begin,0.), i, std::min(outer_temp.end,1.)};
+		*outer = CInterval{i, std::max<distance_t>(outer_temp.begin,0.), i, std::min<distance_t>(outer_temp.end,1.)};
     }
     return CInterval{i, interval.begin, i, interval.end};
 }
@@ -293,8 +451,8 @@ inline void FrechetLight::continueQSimpleSearch(QSimpleInterval& qsimple, Point
 		auto const& cur_point = curve[cur];
 		Interval outer;
 		auto interval = IntersectionAlgorithm::intersection_interval(fixed_point, distance, cur_point, end_point, &outer);
-		outer.begin = std::max(outer.begin, 0.);
-		outer.end = std::min(outer.end, 1.);
+		outer.begin = std::max<distance_t>(outer.begin, 0.);
+		outer.end = std::min<distance_t>(outer.end, 1.);
 		if (interval.is_empty()) {
 			++cur;
 			stepsize *= 2;
@@ -382,7 +540,32 @@ CIntervals::iterator getIntervalContainingNumber(const CIntervals::iterator& beg
 	return end;
 }
 
-void FrechetLight::getReachableIntervals(BoxData& data)
+void FrechetLight::getReachableIntervals(BoxData const& data)
+{
+	auto const base = box_stack.size();
+	box_stack.push_back(BoxTask{data, CIntervalsID(), CIntervalsID()});
+
+	while (box_stack.size() > base) {
+		BoxTask task = box_stack.back();
+		box_stack.pop_back();
+
+		auto& inputs = task.data.inputs;
+		if (task.middle_inputs1.valid()) {
+			auto& middle = reachable_intervals_vec[task.middle_inputs1];
+			inputs.begin1 = middle.begin();
+			inputs.end1 = middle.end();
+		}
+		if (task.middle_inputs2.valid()) {
+			auto& middle = reachable_intervals_vec[task.middle_inputs2];
+			inputs.begin2 = middle.begin();
+			inputs.end2 = middle.end();
+		}
+
+		processBox(task.data);
+	}
+}
+
+inline void FrechetLight::processBox(BoxData& data)
 {
 	++num_boxes;
 
@@ -393,7 +576,7 @@ void FrechetLight::getReachableIntervals(BoxData& data)
 	global::times.newSplit();
 
 	assert(box.max1 > box.min1 && box.max2 > box.min2);
-	assert(outputs.id1.valid() || outputs.id2.valid());
+	assert(data.outputs.id1.valid() || data.outputs.id2.valid());
 
 	firstinterval1 = (inputs.begin1 != inputs.end1) ? &*inputs.begin1 : &empty;
 	firstinterval2 = (inputs.begin2 != inputs.end2) ? &*inputs.begin2 : &empty;
@@ -710,7 +893,7 @@ inline bool FrechetLight::boundaryPruningRule(BoxData& data)
 
 	// special cases for boxes which are at the boundary of the freespace diagram
 	if (pruning_level > 5 && enable_boundary_rule) {
-		if (box.max1 == curve1.size()-1 && out1_valid) {
+		if (box.max1 == curve1.size()-1 && out1_valid && !keep_right_outputs) {
 			visAddUnknown({box.min2,0.}, {box.max2,0.}, {box.max1,0.}, 0);
 			return true;
 		}
@@ -727,15 +910,32 @@ inline void FrechetLight::splitAndRecurse(BoxData& data)
 {
 	auto const& box = data.box;
 
+	if (parallel_box_size > 0 && box.max1 - box.min1 >= parallel_box_size
+		&& box.max2 - box.min2 >= parallel_box_size) {
+		splitIntoQuadrants(data);
+		return;
+	}
+
+	// The second half is pushed first, such that the first half and all boxes
+	// it is split into are processed before it.
 	if (box.max2 - box.min2 > box.max1 - box.min1) { // horizontal split
-		reachable_intervals_vec.emplace_back();
-		CIntervalsID inputs1_middleID = reachable_intervals_vec.size()-1;
+		CIntervalsID inputs1_middleID = reachable_intervals_vec.create();
 
 		PointID split_position = (box.max2 + box.min2) / 2;
 		assert(split_position > box.min2 && split_position < box.max2);
 
 		auto bound = CInterval{split_position, 0., std::numeric_limits<PointID::IDType>::max(),0.};
 		auto it = std::upper_bound(data.inputs.begin2, data.inputs.end2, bound);
+		auto it_top = it;
+		if (it_top != data.inputs.begin2 && (it_top-1)->end >= split_position) { --it_top; }
+
+		BoxData data_top{
+			{box.min1, box.max1, split_position, box.max2},
+			{CIntervals::iterator(), CIntervals::iterator(), it_top, data.inputs.end2},
+			{data.outputs.id1, data.outputs.id2},
+			{data.qsimple_outputs.id1, data.qsimple_outputs.id2}
+		};
+		box_stack.push_back(BoxTask{data_top, inputs1_middleID, CIntervalsID()});
 
 		BoxData data_bottom{
 			{box.min1, box.max1, box.min2, split_position},
@@ -743,27 +943,25 @@ inline void FrechetLight::splitAndRecurse(BoxData& data)
 			{inputs1_middleID, data.outputs.id2},
 			{QSimpleID(), data.qsimple_outputs.id2}
 		};
-		getReachableIntervals(data_bottom);
-
-		if (it != data.inputs.begin2 && (it-1)->end >= split_position) { --it; }
-		CIntervals& inputs1_middle = reachable_intervals_vec[inputs1_middleID];
-
-		BoxData data_top{
-			{box.min1, box.max1, split_position, box.max2},
-			{inputs1_middle.begin(), inputs1_middle.end(), it, data.inputs.end2},
-			{data.outputs.id1, data.outputs.id2},
-			{data.qsimple_outputs.id1, data.qsimple_outputs.id2}
-		};
-		getReachableIntervals(data_top);
+		box_stack.push_back(BoxTask{data_bottom, CIntervalsID(), CIntervalsID()});
 	} else { // vertical split
-		reachable_intervals_vec.emplace_back();
-		CIntervalsID inputs2_middleID = reachable_intervals_vec.size()-1;
+		CIntervalsID inputs2_middleID = reachable_intervals_vec.create();
 
 		PointID split_position = (box.max1 + box.min1) / 2;
 		assert(split_position > box.min1 && split_position < box.max1);
 
 		auto bound = CInterval{split_position, 0., std::numeric_limits<PointID::IDType>::max(), 0.};
 		auto it = std::upper_bound(data.inputs.begin1, data.inputs.end1, bound);
+		auto it_right = it;
+		if (it_right != data.inputs.begin1 && (it_right-1)->end >= split_position) { --it_right; }
+
+		BoxData data_right{
+			{split_position, box.max1, box.min2, box.max2},
+			{it_right, data.inputs.end1, CIntervals::iterator(), CIntervals::iterator()},
+			{data.outputs.id1, data.outputs.id2},
+			{data.qsimple_outputs.id1, data.qsimple_outputs.id2}
+		};
+		box_stack.push_back(BoxTask{data_right, CIntervalsID(), inputs2_middleID});
 
 		BoxData data_left{
 			{box.min1, split_position, box.min2, box.max2},
@@ -771,26 +969,149 @@ inline void FrechetLight::splitAndRecurse(BoxData& data)
 			{data.outputs.id1, inputs2_middleID},
 			{data.qsimple_outputs.id1, QSimpleID()}
 		};
-		getReachableIntervals(data_left);
+		box_stack.push_back(BoxTask{data_left, CIntervalsID(), CIntervalsID()});
+	}
+}
 
-		if (it != data.inputs.begin1 && (it-1)->end >= split_position) { --it; }
-		CIntervals& inputs2_middle = reachable_intervals_vec[inputs2_middleID];
+void FrechetLight::splitIntoQuadrants(BoxData& data)
+{
+	auto const& box = data.box;
 
-		BoxData data_right{
-			{split_position, box.max1, box.min2, box.max2},
-			{it, data.inputs.end1, inputs2_middle.begin(), inputs2_middle.end()},
-			{data.outputs.id1, data.outputs.id2},
-			{data.qsimple_outputs.id1, data.qsimple_outputs.id2}
-		};
-		getReachableIntervals(data_right);
+	PointID split1 = (box.max1 + box.min1) / 2;
+	PointID split2 = (box.max2 + box.min2) / 2;
+	assert(split1 > box.min1 && split1 < box.max1);
+	assert(split2 > box.min2 && split2 < box.max2);
+
+	// split the inputs as in splitAndRecurse
+	auto bound1 = CInterval{split1, 0., std::numeric_limits<PointID::IDType>::max(), 0.};
+	auto it1 = std::upper_bound(data.inputs.begin1, data.inputs.end1, bound1);
+	auto it1_right = it1;
+	if (it1_right != data.inputs.begin1 && (it1_right-1)->end >= split1) { --it1_right; }
+
+	auto bound2 = CInterval{split2, 0., std::numeric_limits<PointID::IDType>::max(), 0.};
+	auto it2 = std::upper_bound(data.inputs.begin2, data.inputs.end2, bound2);
+	auto it2_top = it2;
+	if (it2_top != data.inputs.begin2 && (it2_top-1)->end >= split2) { --it2_top; }
+
+	CIntervalsID middle_left_ID = reachable_intervals_vec.create();
+	CIntervalsID middle_bottom_ID = reachable_intervals_vec.create();
+	CIntervalsID middle_top_ID = reachable_intervals_vec.create();
+
+	BoxData data_bottom_left{
+		{box.min1, split1, box.min2, split2},
+		{data.inputs.begin1, it1, data.inputs.begin2, it2},
+		{middle_left_ID, middle_bottom_ID},
+		{QSimpleID(), QSimpleID()}
+	};
+	getReachableIntervals(data_bottom_left);
+
+	// The bottom right quadrant is computed by a task worker with its own
+	// arenas, while this one computes the top left quadrant. The inputs of both
+	// are not modified anymore and their outputs are disjoint.
+	FrechetLight* worker = getTaskWorker();
+	CIntervalsID worker_middle_right_ID = worker->reachable_intervals_vec.create();
+	CIntervalsID worker_outputs2_ID;
+	if (data.outputs.id2.valid()) {
+		worker_outputs2_ID = worker->reachable_intervals_vec.create();
+	}
+
+	CIntervals& middle_bottom = reachable_intervals_vec[middle_bottom_ID];
+	BoxData data_bottom_right{
+		{split1, box.max1, box.min2, split2},
+		{it1_right, data.inputs.end1, middle_bottom.begin(), middle_bottom.end()},
+		{worker_middle_right_ID, worker_outputs2_ID},
+		{QSimpleID(), QSimpleID()}
+	};
+
+	CIntervals& middle_left = reachable_intervals_vec[middle_left_ID];
+	BoxData data_top_left{
+		{box.min1, split1, split2, box.max2},
+		{middle_left.begin(), middle_left.end(), it2_top, data.inputs.end2},
+		{data.outputs.id1, middle_top_ID},
+		{QSimpleID(), QSimpleID()}
+	};
+
+#ifdef WITH_OPENMP
+	#pragma omp task firstprivate(worker) shared(data_bottom_right)
+#endif
+	worker->getReachableIntervals(data_bottom_right);
+
+	getReachableIntervals(data_top_left);
+
+#ifdef WITH_OPENMP
+	#pragma omp taskwait
+#endif
+
+	joinTaskWorker(*worker, worker_outputs2_ID, data.outputs.id2);
+
+	CIntervals& middle_right = worker->reachable_intervals_vec[worker_middle_right_ID];
+	CIntervals& middle_top = reachable_intervals_vec[middle_top_ID];
+	BoxData data_top_right{
+		{split1, box.max1, split2, box.max2},
+		{middle_right.begin(), middle_right.end(), middle_top.begin(), middle_top.end()},
+		{data.outputs.id1, data.outputs.id2},
+		{data.qsimple_outputs.id1, data.qsimple_outputs.id2}
+	};
+	getReachableIntervals(data_top_right);
+}
+
+FrechetLight* FrechetLight::getTaskWorker()
+{
+	if (num_task_workers == task_workers.size()) {
+		task_workers.emplace_back(new FrechetLight());
 	}
+	FrechetLight* worker = task_workers[num_task_workers++].get();
+
+	worker->curve_pair = curve_pair;
+	worker->distance = distance;
+	worker->dist_sqr = dist_sqr;
+	worker->pruning_level = pruning_level;
+	worker->enable_box_shrinking = enable_box_shrinking;
+	worker->enable_empty_outputs = enable_empty_outputs;
+	worker->enable_propagation1 = enable_propagation1;
+	worker->enable_propagation2 = enable_propagation2;
+	worker->enable_boundary_rule = enable_boundary_rule;
+	worker->parallel_box_size = parallel_box_size;
+	worker->keep_right_outputs = keep_right_outputs;
+	worker->clear();
+#ifdef CERTIFY
+	worker->empty_intervals.clear();
+#endif
+	worker->num_boxes = 0;
+
+	return worker;
+}
+
+void FrechetLight::joinTaskWorker(FrechetLight const& worker, CIntervalsID worker_outputs2, CIntervalsID outputs2)
+{
+	if (outputs2.valid()) {
+		for (auto const& interval: worker.reachable_intervals_vec[worker_outputs2]) {
+			merge(reachable_intervals_vec[outputs2], interval);
+		}
+	}
+	num_boxes += worker.num_boxes;
+
+#ifdef CERTIFY
+	empty_intervals.insert(empty_intervals.end(), worker.empty_intervals.begin(), worker.empty_intervals.end());
+#endif
+#ifdef VIS
+	unknown_intervals.insert(unknown_intervals.end(), worker.unknown_intervals.begin(), worker.unknown_intervals.end());
+	connections.insert(connections.end(), worker.connections.begin(), worker.connections.end());
+	free_non_reachable.insert(free_non_reachable.end(), worker.free_non_reachable.begin(), worker.free_non_reachable.end());
+	reachable_intervals.insert(reachable_intervals.end(), worker.reachable_intervals.begin(), worker.reachable_intervals.end());
+	cells.insert(cells.end(), worker.cells.begin(), worker.cells.end());
+#endif
 }
 
 CPoint FrechetLight::getLastReachablePoint(Point const& point, Curve const& curve) const
 {
-	PointID max = curve.size()-1;
+	return getLastReachablePoint(point, curve, 0, curve.size()-1);
+}
+
+CPoint FrechetLight::getLastReachablePoint(Point const& point, Curve const& curve, PointID min, PointID max) const
+{
 	std::size_t stepsize = 1;
-	for (PointID cur = 0; cur < max; ) {
+	for (PointID cur = min; cur < max; ) {
 		// heuristic steps:
 		stepsize = std::min<std::size_t>(stepsize, max - cur);
 
@@ -868,6 +1189,70 @@ bool FrechetLight::lessThan(distance_t distance, Curve const& curve1, Curve cons
 	return isTopRightReachable(final_outputs);
 }
 
+void FrechetLight::startIncremental(distance_t distance, Curve const& curve1, Curve const& curve2)
+{
+	assert(curve1.size());
+	assert(curve2.size());
+
+	this->curve_pair[0] = &curve1;
+	this->curve_pair[1] = &curve2;
+	this->distance = distance;
+	this->dist_sqr = distance * distance;
+
+	// the right boundary is the left boundary of the whole diagram
+	incremental_end = 0;
+	incremental_right.clear();
+	incremental_bottom_reachable = curve1.front().dist_sqr(curve2.front()) <= dist_sqr;
+	if (incremental_bottom_reachable) {
+		incremental_right.emplace_back(CPoint(0, 0.), getLastReachablePoint(curve1.front(), curve2));
+	}
+}
+
+bool FrechetLight::lessThanIncremental()
+{
+	auto const& curve1 = *curve_pair[0];
+	auto const& curve2 = *curve_pair[1];
+	PointID const new_end = curve1.size()-1;
+	assert(new_end >= incremental_end);
+
+	if (new_end > incremental_end && curve2.size() == 1) {
+		// the diagram has no height, so there is only the bottom boundary
+		if (incremental_bottom_reachable) {
+			auto last = getLastReachablePoint(curve2.front(), curve1, incremental_end, new_end);
+			incremental_bottom_reachable = (last == new_end);
+		}
+	}
+	else if (new_end > incremental_end && (incremental_bottom_reachable || !incremental_right.empty())) {
+		clear();
+
+		CIntervalsID inputs1ID = reachable_intervals_vec.create();
+		CIntervalsID inputs2ID = reachable_intervals_vec.create();
+		auto& inputs1 = reachable_intervals_vec[inputs1ID];
+		auto& inputs2 = reachable_intervals_vec[inputs2ID];
+		if (incremental_bottom_reachable) {
+			auto last = getLastReachablePoint(curve2.front(), curve1, incremental_end, new_end);
+			inputs1.emplace_back(CPoint(incremental_end, 0.), last);
+			incremental_bottom_reachable = (last == new_end);
+		}
+		inputs2 = incremental_right;
+
+		Box box(incremental_end, new_end, 0, curve2.size()-1);
+		Inputs inputs{inputs1.begin(), inputs1.end(), inputs2.begin(), inputs2.end()};
+		Outputs outputs = createFinalOutputs();
+
+		keep_right_outputs = true;
+		computeOutputs(box, inputs, outputs);
+		keep_right_outputs = false;
+
+		incremental_right = reachable_intervals_vec[outputs.id2];
+	}
+	// otherwise nothing is reachable anymore and the right boundary stays empty
+	incremental_end = new_end;
+
+	if (curve2.size() == 1) { return incremental_bottom_reachable; }
+	return !incremental_right.empty() && incremental_right.back().end == PointID(curve2.size()-1);
+}
+
 bool FrechetLight::lessThanWithFilters(distance_t distance, Curve const& curve1, Curve const& curve2)
 {
 	this->curve_pair[0] = &curve1;
@@ -916,7 +1301,16 @@ inline void FrechetLight::computeOutputs(
 	num_boxes = 0;
 
 	BoxData box_data{initial_box, initial_inputs, final_outputs, QSimpleOutputs()};
-	getReachableIntervals(box_data);
+	if (parallel_box_size > 0) {
+#ifdef WITH_OPENMP
+		#pragma omp parallel
+		#pragma omp single
+#endif
+		getReachableIntervals(box_data);
+	}
+	else {
+		getReachableIntervals(box_data);
+	}
 }
 
 inline void FrechetLight::visAddCell(Box const& box)
@@ -966,10 +1360,8 @@ inline auto FrechetLight::createFinalOutputs() -> Outputs
 {
 	Outputs outputs;
 
-	reachable_intervals_vec.emplace_back();
-	outputs.id1 = reachable_intervals_vec.size()-1;
-	reachable_intervals_vec.emplace_back();
-	outputs.id2 = reachable_intervals_vec.size()-1;
+	outputs.id1 = reachable_intervals_vec.create();
+	outputs.id2 = reachable_intervals_vec.create();
 
 	return outputs;
 }
@@ -985,29 +1377,44 @@ inline auto FrechetLight::computeInitialInputs() -> Inputs
 	auto const first = CPoint(0,0.);
 
 	auto last1 = getLastReachablePoint(curve2.front(), curve1);
-	reachable_intervals_vec.emplace_back();
-	reachable_intervals_vec.back().emplace_back(first, last1);
-	inputs.begin1 = reachable_intervals_vec.back().begin();
-	inputs.end1 = reachable_intervals_vec.back().end();
+	auto& inputs1 = reachable_intervals_vec[reachable_intervals_vec.create()];
+	inputs1.emplace_back(first, last1);
+	inputs.begin1 = inputs1.begin();
+	inputs.end1 = inputs1.end();
 
 	auto last2 = getLastReachablePoint(curve1.front(), curve2);
-	reachable_intervals_vec.emplace_back();
-	reachable_intervals_vec.back().emplace_back(first, last2);
-	inputs.begin2 = reachable_intervals_vec.back().begin();
-	inputs.end2 = reachable_intervals_vec.back().end();
+	auto& inputs2 = reachable_intervals_vec[reachable_intervals_vec.create()];
+	inputs2.emplace_back(first, last2);
+	inputs.begin2 = inputs2.begin();
+	inputs.end2 = inputs2.end();
 
 	return inputs;
 }
 
 distance_t FrechetLight::calcDistance(Curve const& curve1, Curve const& curve2)
 {
-	static constexpr distance_t epsilon = 1e-10;
+	distance_t min = Filter::lowerBound(curve1, curve2);
+	distance_t max = Filter::upperBound(curve1, curve2);
+
+	return bisectDistance(min, max, curve1, curve2);
+}
+
+distance_t FrechetLight::calcDistance(Curve const& curve1, Curve const& curve2, distance_t min, distance_t max)
+{
+	max = std::min(max, Filter::upperBound(curve1, curve2));
+	min = std::min(std::max(min, Filter::lowerBound(curve1, curve2)), max);
 
-	distance_t min = 0.;
-	distance_t max = curve1.getUpperBoundDistance(curve2);
+	return bisectDistance(min, max, curve1, curve2);
+}
+
+distance_t FrechetLight::bisectDistance(distance_t min, distance_t max, Curve const& curve1, Curve const& curve2)
+{
+	static constexpr distance_t epsilon = 1e-10;
 
 	while (max - min >= epsilon) {
-		auto split = (max + min)/2.;
+		distance_t split = (max + min)/2.;
+		// with float, epsilon might be below the precision of the distances
+		if (split <= min || split >= max) { break; }
 		if (lessThanWithFilters(split, curve1, curve2)) {
 			max = split;
 		}
@@ -1019,12 +1426,77 @@ distance_t FrechetLight::calcDistance(Curve const& curve1, Curve const& curve2)
 	return (max + min)/2.;
 }
 
+distance_t FrechetLight::calcDistanceExact(Curve const& curve1, Curve const& curve2)
+{
+	// bounds the number of pairs of points considered for monotonicity events
+	static constexpr std::size_t max_event_pairs = 1 << 20;
+	static constexpr std::size_t num_bisection_steps = 8;
+
+	// the lower bound is a point-segment or endpoint distance, i.e., a critical value
+	distance_t min = Filter::lowerBound(curve1, curve2);
+	if (lessThanTolerant(min, curve1, curve2)) { return min; }
+	distance_t max = Filter::upperBound(curve1, curve2);
+
+	// a few bisection steps first, such that fewer point-segment distances lie
+	// in (min, max]
+	for (std::size_t step = 0; step < num_bisection_steps; ++step) {
+		distance_t split = (max + min)/2.;
+		if (lessThanTolerant(split, curve1, curve2)) {
+			max = split;
+		}
+		else {
+			min = split;
+		}
+	}
+
+	std::vector<distance_t> values;
+	addPointSegmentDistances(curve1, curve2, min, max, values);
+	addPointSegmentDistances(curve2, curve1, min, max, values);
+	max = searchCriticalValues(values, min, max, curve1, curve2);
+
+	values.clear();
+	std::size_t budget = max_event_pairs;
+	if (!addMonotonicityEvents(curve1, curve2, min, max, values, budget) ||
+	    !addMonotonicityEvents(curve2, curve1, min, max, values, budget)) {
+		return bisectDistance(min, max, curve1, curve2);
+	}
+	return searchCriticalValues(values, min, max, curve1, curve2);
+}
+
+bool FrechetLight::lessThanTolerant(distance_t distance, Curve const& curve1, Curve const& curve2)
+{
+	return lessThanWithFilters(distance*(1 + critical_value_tolerance) + eps, curve1, curve2);
+}
+
+distance_t FrechetLight::searchCriticalValues(std::vector<distance_t>& values, distance_t& min, distance_t max, Curve const& curve1, Curve const& curve2)
+{
+	// Binary search using selection instead of sorting. Everything before
+	// begin is no and everything from end on is yes.
+	auto begin = values.begin();
+	auto end = values.end();
+	while (begin != end) {
+		auto mid = begin + (end - begin)/2;
+		std::nth_element(begin, mid, end);
+		if (lessThanTolerant(*mid, curve1, curve2)) {
+			max = *mid;
+			end = mid;
+		}
+		else {
+			min = *mid;
+			begin = mid + 1;
+		}
+	}
+
+	return max;
+}
+
 // This doesn't have to be called but is handy to make time measurements more consistent
 // such that the clears in the lessThan call doen't have to do anything.
 void FrechetLight::clear()
 {
 	reachable_intervals_vec.clear();
 	qsimple_intervals.clear();
+	num_task_workers = 0;
 
 #ifdef VIS
 	unknown_intervals.clear();
@@ -1296,3 +1768,9 @@ std::size_t FrechetLight::getNumberOfBoxes() const
 {
 	return num_boxes;
 }
+
+void FrechetLight::setParallelBoxSize(std::size_t size)
+{
+	// quadrants need at least one segment per side
+	parallel_box_size = size == 0 ? 0 : std::max<std::size_t>(size, 2);
+}
@@ -13,6 +13,7 @@
 #endif
 
 #include <array>
+#include <memory>
 #include <vector>
 
 class FrechetLight final : public FrechetAbstract
@@ -21,12 +22,25 @@ class FrechetLight final : public FrechetAbstract
 
 public:
 	static constexpr distance_t eps = 1e-10;
+	// relative amount by which calcDistanceExact runs the decider above a critical value
+	static constexpr distance_t critical_value_tolerance = 1e-7;
 	
 	FrechetLight() = default;
 	void buildFreespaceDiagram(distance_t distance, Curve const& curve1, Curve const& curve2);
 	bool lessThan(distance_t distance, Curve const& curve1, Curve const& curve2) override;
 	bool lessThanWithFilters(distance_t distance, Curve const& curve1, Curve const& curve2);
 	distance_t calcDistance(Curve const& curve1, Curve const& curve2);
+	// same, but the distance is known to lie in [min, max], e.g., by the
+	// triangle inequality, which is combined with the bounds of Filter
+	distance_t calcDistance(Curve const& curve1, Curve const& curve2, distance_t min, distance_t max);
+	// Computes the Frechet distance as the smallest critical value which the
+	// decider accepts (run slightly above the value to be robust against
+	// rounding), instead of bisecting down to a fixed precision. The
+	// candidates are the endpoint distances, the distances of points to the
+	// segments of the other curve and, between the two point-segment distances
+	// around the result, the monotonicity events of two points and a segment.
+	// If there are too many of the latter, the last step falls back to bisection.
+	distance_t calcDistanceExact(Curve const& curve1, Curve const& curve2);
 	void clear();
 
 	CurvePair getCurvePair() const;
@@ -38,17 +52,52 @@ public:
 
 	std::size_t getNumberOfBoxes() const;
 
+	// Opt-in parallel mode for single large decisions: boxes with at least
+	// `size` segments on both curves are split into four quadrants, and the
+	// two quadrants which only depend on the bottom left one are computed in
+	// parallel as OpenMP tasks. 0 disables the parallel mode (default).
+	void setParallelBoxSize(std::size_t size);
+
 	std::size_t non_filtered = 0;
 
+	// Incremental mode for a curve1 which grows by appending points, e.g. a
+	// live trajectory, which is compared to a fixed curve2 at a fixed
+	// distance. startIncremental sets up the free space diagram for the first
+	// point of curve1. Each call of lessThanIncremental then decides for the
+	// current curve1, but only processes the columns of the points appended
+	// since the last call. It starts from the reachable intervals which were
+	// kept on the previous right boundary. The curves have to stay alive in
+	// between, and certificates are not available in this mode.
+	void startIncremental(distance_t distance, Curve const& curve1, Curve const& curve2);
+	bool lessThanIncremental();
+
 private:
 	CurvePair curve_pair;
 
 	distance_t distance;
 	distance_t dist_sqr;
 
-	std::vector<CIntervals> reachable_intervals_vec;
+	CIntervalsArena reachable_intervals_vec;
 	QSimpleIntervals qsimple_intervals;
 	std::size_t num_boxes;
+	BoxTasks box_stack;
+
+	// Workers computing quadrants in parallel mode. Each has its own arenas
+	// and is kept until the next decision, as the intervals computed by it can
+	// be referenced by the certificate.
+	std::size_t parallel_box_size = 0;
+	std::vector<std::unique_ptr<FrechetLight>> task_workers;
+	std::size_t num_task_workers = 0;
+
+	// state of the incremental mode: the last processed point of curve1,
+	// whether all of the bottom boundary up to it is reachable, and the
+	// reachable intervals on the right boundary at it
+	PointID incremental_end;
+	bool incremental_bottom_reachable = false;
+	CIntervals incremental_right;
+	// the incremental mode needs the complete right boundary, so the boundary
+	// pruning rule must not skip it
+	bool keep_right_outputs = false;
 
 	// 0 = no pruning ... 6 = full pruning
 	int pruning_level = 6;
@@ -95,12 +144,26 @@ private:
 	distance_t getDistToPointSqr(const Curve& curve, Point const& point) const;
 	bool isClose(Point const& point, Curve const& curve) const;
 	CPoint getLastReachablePoint(Point const& point, Curve const& curve) const;
+	// same, but starting at point min of the curve and stopping at point max
+	CPoint getLastReachablePoint(Point const& point, Curve const& curve, PointID min, PointID max) const;
 	bool isTopRightReachable(Outputs const& outputs) const;
+	distance_t bisectDistance(distance_t min, distance_t max, Curve const& curve1, Curve const& curve2);
+	// At a critical value the free space only touches, so calcDistanceExact
+	// runs the decider slightly above the distance to be robust against its rounding.
+	bool lessThanTolerant(distance_t distance, Curve const& curve1, Curve const& curve2);
+	// Returns the smallest of the values (which have to lie in (min, max]) for
+	// which lessThanTolerant answers yes, or max if there is none. min is set
+	// to the largest value for which it answers no. The values are reordered.
+	distance_t searchCriticalValues(std::vector<distance_t>& values, distance_t& min, distance_t max, Curve const& curve1, Curve const& curve2);
 	void computeOutputs(Box const& initial_box, Inputs const& initial_inputs, Outputs& final_outputs);
 
-	void getReachableIntervals(BoxData& data);
+	// Computes the outputs of the box using an explicit stack of boxes instead
+	// of recursion. Only the part of the stack above its current top is used,
+	// so it can be called again while processing a box.
+	void getReachableIntervals(BoxData const& data);
 
 	// subfunctions of getReachableIntervals
+	void processBox(BoxData& data);
 	bool emptyInputsRule(BoxData& data);
 	void boxShrinkingRule(BoxData& data);
 	void handleCellCase(BoxData& data);
@@ -109,6 +172,10 @@ private:
 	void calculateQSimple2(BoxData& data);
 	bool boundaryPruningRule(BoxData& data);
 	void splitAndRecurse(BoxData& data);
+	void splitIntoQuadrants(BoxData& data);
+
+	FrechetLight* getTaskWorker();
+	void joinTaskWorker(FrechetLight const& worker, CIntervalsID worker_outputs2, CIntervalsID outputs2);
 
 	// intervals used in getReachableIntervals and subfunctions
 	CInterval const empty;
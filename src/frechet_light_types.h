@@ -4,6 +4,7 @@
 #include "id.h"
 #include "curves.h"
 
+#include <cassert>
 #include <vector>
 
 //
@@ -25,6 +26,42 @@ struct Box {
 };
 using Boxes = std::vector<Box>;
 
+//
+// CIntervalsArena
+//
+
+// Pool of interval lists. Clearing it only empties the lists but keeps them
+// and their capacity, such that after warm-up repeated decisions on similar
+// curve pairs do not allocate any memory. Lists are appended to in an
+// interleaved way during the recursion, so they are separate vectors and not
+// ranges of one buffer.
+class CIntervalsArena
+{
+public:
+	CIntervalsID create()
+	{
+		if (num_used == lists.size()) {
+			lists.emplace_back();
+		}
+		return num_used++;
+	}
+	void clear()
+	{
+		for (std::size_t i = 0; i < num_used; ++i) {
+			lists[i].clear();
+		}
+		num_used = 0;
+	}
+
+	CIntervals& operator[](CIntervalsID id) { assert(id < num_used); return lists[id]; }
+	CIntervals const& operator[](CIntervalsID id) const { assert(id < num_used); return lists[id]; }
+	std::size_t size() const { return num_used; }
+
+private:
+	std::vector<CIntervals> lists;
+	std::size_t num_used = 0;
+};
+
 //
 // Inputs
 //
@@ -166,3 +203,18 @@ struct BoxData {
 	Outputs outputs;
 	QSimpleOutputs qsimple_outputs;
 };
+
+//
+// BoxTask
+//
+
+// Entry of the work stack of FrechetLight. The second half of a split box is
+// pushed before its first half has been computed, so inputs coming from the
+// middle boundary are only given by the ID of the list the first half writes
+// to. They are resolved when the task is taken from the stack.
+struct BoxTask {
+	BoxData data;
+	CIntervalsID middle_inputs1;
+	CIntervalsID middle_inputs2;
+};
+using BoxTasks = std::vector<BoxTask>;
@@ -10,53 +10,83 @@ bool FrechetNaive::lessThan(distance_t distance, Curve const& curve1, Curve cons
 {
 	assert(curve1.size() >= 2);
 	assert(curve2.size() >= 2);
+
+	// The free space is traversed row by row with only the current row in
+	// memory, so let the rows run along the shorter curve. The decision is
+	// symmetric and the free intervals are computed by the same primitive
+	// either way, so this does not change the result.
+	if (curve2.size() > curve1.size()) { return lessThan(distance, curve2, curve1); }
+
 	distance_t dist_sqr = distance * distance;
 
 	if (curve1[0].dist_sqr(curve2[0]) > dist_sqr || curve1.back().dist_sqr(curve2.back()) > dist_sqr) { return false; }
 
 	distance_t infty = std::numeric_limits<distance_t>::max();
-
-	std::vector<std::vector<distance_t>> reachable1(curve1.size()-1, std::vector<distance_t>(curve2.size(), infty));
-	std::vector<std::vector<distance_t>> reachable2(curve1.size(), std::vector<distance_t>(curve2.size()-1, infty));
-	for (size_t i = 0; i < curve1.size() - 1; ++i) {
-		reachable1[i][0] = 0.;
-		if (curve2[0].dist_sqr(curve1[i+1]) > dist_sqr) { break; }
-	}
-	for (size_t j = 0; j < curve2.size() - 1; ++j) {
-		reachable2[0][j] = 0.;
+	std::size_t const n = curve1.size();
+	std::size_t const m = curve2.size();
+
+	// reachable1[j] is on segment i of curve1 at point j of curve2,
+	// reachable2[j] is on segment j of curve2 at point i of curve1;
+	// both are overwritten with row i in iteration i.
+	std::vector<distance_t> reachable1(m, infty);
+	std::vector<distance_t> reachable2(m-1, infty);
+	for (size_t j = 0; j < m - 1; ++j) {
+		reachable2[j] = 0.;
 		if (curve1[0].dist_sqr(curve2[j+1]) > dist_sqr) { break; }
 	}
-
-	for (size_t i = 0; i < curve1.size(); ++i) {
-		for (size_t j = 0; j < curve2.size(); ++j) {
-			if (i < curve1.size() - 1 && j > 0) {
-				Interval free_int = IntersectionAlgorithm::intersection_interval(curve2[j], distance, curve1[i], curve1[i+1]);
-				if (!free_int.is_empty()) {
-					if (reachable2[i][j-1] != infty) {
-						reachable1[i][j] = free_int.begin;
-					}
-					else if (reachable1[i][j-1] <= free_int.end) {
-						reachable1[i][j] = std::max(free_int.begin, reachable1[i][j-1]);
-					}
-				}
+	bool first_column_reachable = true;
+
+	// free intervals of the current row, computed in batches:
+	// free1[j-1] belongs to reachable1[j], free2[j] to reachable2[j]
+	std::vector<Interval> free1(m-1);
+	std::vector<Interval> free2(m-1);
+
+	for (size_t i = 0; i < n; ++i) {
+		// Reachability from the row below. This only depends on the previous
+		// values at the same position, so the loop is vectorizable.
+		if (i > 0) {
+			IntersectionAlgorithm::intersection_intervals(curve1[i], distance, curve2.xs(), curve2.ys(),
+				m - 1, free2.data());
+
+#pragma omp simd
+			for (size_t j = 0; j < m - 1; ++j) {
+				distance_t const begin = free2[j].begin;
+				distance_t const end = free2[j].end;
+				distance_t const from_below = reachable2[j];
+				distance_t const from_left = reachable1[j];
+				distance_t const reached = from_left != infty ? begin :
+					(from_below <= end ? std::max(begin, from_below) : infty);
+				reachable2[j] = begin > end ? infty : reached;
 			}
-			if (j < curve2.size() - 1 && i > 0) {
-				Interval free_int = IntersectionAlgorithm::intersection_interval(curve1[i], distance, curve2[j], curve2[j+1]);
-				if (!free_int.is_empty()) {
-					if (reachable1[i-1][j] != infty) {
-						reachable2[i][j] = free_int.begin;
-					}
-					else if (reachable2[i-1][j] <= free_int.end) {
-						reachable2[i][j] = std::max(free_int.begin, reachable2[i-1][j]);
-					}
+		}
+		if (i == n - 1) { break; }
+
+		// Reachability within the row: a running maximum of the interval starts,
+		// restarted whenever the cell is entered from below and cut off by the
+		// first interval ending before the maximum.
+		IntersectionAlgorithm::intersection_intervals(curve2.xs() + 1, curve2.ys() + 1, m - 1,
+			distance, curve1[i], curve1[i+1], free1.data());
+
+		reachable1[0] = first_column_reachable ? 0. : infty;
+		if (curve2[0].dist_sqr(curve1[i+1]) > dist_sqr) { first_column_reachable = false; }
+		for (size_t j = 1; j < m; ++j) {
+			Interval const& free_int = free1[j-1];
+			distance_t reached = infty;
+			if (!free_int.is_empty()) {
+				if (reachable2[j-1] != infty) {
+					reached = free_int.begin;
+				}
+				else if (reachable1[j-1] <= free_int.end) {
+					reached = std::max(free_int.begin, reachable1[j-1]);
 				}
 			}
+			reachable1[j] = reached;
 		}
 	}
 
-	assert((reachable1.back().back() < infty) == (reachable2.back().back() < infty));
+	assert((reachable1.back() < infty) == (reachable2.back() < infty));
 
-	return reachable1.back().back() < infty;
+	return reachable1.back() < infty;
 }
 
 bool FrechetNaive::lessThanWithFilters(distance_t distance, Curve const& curve1, Curve const& curve2)
@@ -5,6 +5,8 @@
 #include "geometry_basics.h"
 #include "curves.h"
 
+namespace unit_tests { void testFrechetNaive(); }
+
 class FrechetNaive final : public FrechetAbstract
 {
 public:
@@ -0,0 +1,134 @@
+#include "frechet_wavefront.h"
+
+#include "defs.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+distance_t const infty = std::numeric_limits<distance_t>::max();
+
+} // end anonymous namespace
+
+void FrechetWavefront::setTileSize(std::size_t size)
+{
+	if (size == 0) {
+		ERROR("The tile size has to be positive.");
+	}
+	tile_size = size;
+}
+
+bool FrechetWavefront::lessThan(distance_t distance, Curve const& curve1, Curve const& curve2)
+{
+	assert(curve1.size() >= 2);
+	assert(curve2.size() >= 2);
+	distance_t dist_sqr = distance * distance;
+
+	if (curve1[0].dist_sqr(curve2[0]) > dist_sqr || curve1.back().dist_sqr(curve2.back()) > dist_sqr) { return false; }
+
+	std::size_t const num_rows = curve1.size() - 1;
+	std::size_t const num_columns = curve2.size() - 1;
+
+	// left[i] is the boundary between the last processed tile of the tile row
+	// containing cell row i and the next one, bottom[j] analogously for columns
+	std::vector<distance_t> left(num_rows, infty);
+	std::vector<distance_t> bottom(num_columns, infty);
+	for (size_t i = 0; i < num_rows; ++i) {
+		left[i] = 0.;
+		if (curve2[0].dist_sqr(curve1[i+1]) > dist_sqr) { break; }
+	}
+	for (size_t j = 0; j < num_columns; ++j) {
+		bottom[j] = 0.;
+		if (curve1[0].dist_sqr(curve2[j+1]) > dist_sqr) { break; }
+	}
+
+	std::size_t const num_tile_rows = (num_rows + tile_size - 1)/tile_size;
+	std::size_t const num_tile_columns = (num_columns + tile_size - 1)/tile_size;
+
+	for (std::size_t diagonal = 0; diagonal < num_tile_rows + num_tile_columns - 1; ++diagonal) {
+		std::size_t const first = diagonal < num_tile_columns ? 0 : diagonal - num_tile_columns + 1;
+		std::size_t const last = std::min(diagonal, num_tile_rows - 1);
+		std::size_t const num_tiles = last - first + 1;
+		bool any_reachable = false;
+
+#ifdef WITH_OPENMP
+		#pragma omp parallel for schedule(dynamic) reduction(||:any_reachable) if(num_tiles > 1)
+#endif
+		for (std::size_t tile_row = first; tile_row <= last; ++tile_row) {
+			std::size_t const tile_column = diagonal - tile_row;
+			std::size_t const i0 = tile_row*tile_size;
+			std::size_t const j0 = tile_column*tile_size;
+			std::size_t const i1 = std::min(i0 + tile_size, num_rows);
+			std::size_t const j1 = std::min(j0 + tile_size, num_columns);
+			if (processTile(distance, curve1, curve2, i0, i1, j0, j1, &left[i0], &bottom[j0])) {
+				any_reachable = true;
+			}
+		}
+
+		// every path to the end crosses the outer boundary of this anti-diagonal
+		if (!any_reachable) { return false; }
+	}
+
+	// The position on the last segment of curve1 at the end of curve2 is in
+	// the left boundary of the last tile row.
+	return left.back() < infty;
+}
+
+bool FrechetWavefront::processTile(distance_t distance, Curve const& curve1, Curve const& curve2,
+	std::size_t i0, std::size_t i1, std::size_t j0, std::size_t j1,
+	distance_t* left, distance_t* bottom) const
+{
+	std::size_t const width = j1 - j0;
+
+	// reachable1[k] is on segment i of curve1 at point j0+k of curve2,
+	// bottom[k] on segment j0+k of curve2 at point i of curve1
+	std::vector<distance_t> reachable1(width + 1);
+	std::vector<Interval> free1(width);
+	std::vector<Interval> free2(width);
+
+	bool any_reachable = false;
+	for (std::size_t i = i0; i < i1; ++i) {
+		// within the row, see FrechetNaive::lessThan
+		IntersectionAlgorithm::intersection_intervals(curve2.xs() + j0 + 1, curve2.ys() + j0 + 1, width,
+			distance, curve1[i], curve1[i+1], free1.data());
+
+		reachable1[0] = left[i - i0];
+		for (std::size_t k = 1; k <= width; ++k) {
+			Interval const& free_int = free1[k-1];
+			distance_t reached = infty;
+			if (!free_int.is_empty()) {
+				if (bottom[k-1] != infty) {
+					reached = free_int.begin;
+				}
+				else if (reachable1[k-1] <= free_int.end) {
+					reached = std::max(free_int.begin, reachable1[k-1]);
+				}
+			}
+			reachable1[k] = reached;
+		}
+		left[i - i0] = reachable1[width];
+		any_reachable = any_reachable || reachable1[width] != infty;
+
+		// to the next row
+		IntersectionAlgorithm::intersection_intervals(curve1[i+1], distance, curve2.xs() + j0, curve2.ys() + j0,
+			width, free2.data());
+
+#pragma omp simd
+		for (std::size_t k = 0; k < width; ++k) {
+			distance_t const begin = free2[k].begin;
+			distance_t const end = free2[k].end;
+			distance_t const reached = reachable1[k] != infty ? begin :
+				(bottom[k] <= end ? std::max(begin, bottom[k]) : infty);
+			bottom[k] = begin > end ? infty : reached;
+		}
+	}
+
+	for (std::size_t k = 0; k < width; ++k) {
+		any_reachable = any_reachable || bottom[k] != infty;
+	}
+
+	return any_reachable;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "defs.h"
+#include "frechet_abstract.h"
+#include "geometry_basics.h"
+#include "curves.h"
+
+#include <vector>
+
+namespace unit_tests { void testFrechetWavefront(); }
+
+// Decider which splits the free space diagram into square tiles of cells and
+// processes the tiles anti-diagonal by anti-diagonal. All tiles on one
+// anti-diagonal only depend on tiles of the previous one and are computed in
+// parallel. Tiles pass the reachable intervals on their right and top
+// boundaries to their neighbors. Within a tile, the free space is computed row
+// by row as in FrechetNaive, so the memory use is O(n + m).
+class FrechetWavefront final : public FrechetAbstract
+{
+public:
+	FrechetWavefront() {
+		std::cout << "Initializing FrechetWavefront algorithm...\n";
+	};
+	bool lessThan(distance_t distance, Curve const& curve1, Curve const& curve2);
+	Certificate&  computeCertificate() { return cert; }
+
+	// number of cells per tile side
+	void setTileSize(std::size_t size);
+
+private:
+	Certificate cert;
+	std::size_t tile_size = 256;
+
+	// Processes the cells [i0,i1) x [j0,j1). On entry, left[k] is the reachable
+	// position on segment i0+k of curve1 at point j0 of curve2, and bottom[k] on
+	// segment j0+k of curve2 at point i0 of curve1; both are overwritten with the
+	// positions on the opposite side of the tile. Returns whether any position on
+	// the opposite sides is reachable.
+	bool processTile(distance_t distance, Curve const& curve1, Curve const& curve2,
+		std::size_t i0, std::size_t i1, std::size_t j0, std::size_t j1,
+		distance_t* left, distance_t* bottom) const;
+};
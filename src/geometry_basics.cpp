@@ -1,5 +1,9 @@
 #include "geometry_basics.h"
 
+#include "simd.h"
+
+#include <algorithm>
+
 namespace
 {
 
@@ -67,6 +71,17 @@ distance_t Point::dist(const Point& point) const
     return std::sqrt(dist_sqr(point));
 }
 
+distance_t segmentDistanceSqr(Point const& point, Point const& start, Point const& end)
+{
+	auto const v = end - start;
+	auto const length_sqr = v.x*v.x + v.y*v.y;
+	if (length_sqr == 0) { return point.dist_sqr(start); }
+
+	auto const w = point - start;
+	auto const t = std::min<distance_t>(1., std::max<distance_t>(0., (w.x*v.x + w.y*v.y)/length_sqr));
+	return point.dist_sqr(start + v*t);
+}
+
 std::ostream& operator<<(std::ostream& out, const Point& p)
 {
     out << std::setprecision (15)
@@ -272,6 +287,120 @@ Interval IntersectionAlgorithm::intersection_interval(Point circle_center, dista
 	return Interval{ begin, end };
 }
 
+// Computes the intersection intervals for lanes k in [0, num). Lane k has the
+// circle center (center_xs[0], center_ys[0]) and the segment from point k to k+1
+// of (xs, ys), or, if !fixed_center, the circle center k and the segment from
+// point 0 to 1. The vectorized part follows intersection_interval step by step
+// without branches, such that the results are bit identical. Lanes which would
+// need a binary search are handed to intersection_interval, as is the remainder.
+template <bool fixed_center>
+void IntersectionAlgorithm::intersection_intervals_kernel(distance_t const* center_xs, distance_t const* center_ys,
+	distance_t const* xs, distance_t const* ys, std::size_t num, distance_t radius, Interval* free, Interval* outer)
+{
+	auto scalar = [&](std::size_t k) {
+		const Point center = fixed_center ? Point{center_xs[0], center_ys[0]} : Point{center_xs[k], center_ys[k]};
+		const Point start = fixed_center ? Point{xs[k], ys[k]} : Point{xs[0], ys[0]};
+		const Point end = fixed_center ? Point{xs[k+1], ys[k+1]} : Point{xs[1], ys[1]};
+		free[k] = intersection_interval(center, radius, start, end, outer == nullptr ? nullptr : &outer[k]);
+	};
+
+	std::size_t k = 0;
+
+#ifdef FRECHET_SIMD
+	using simd::Vec;
+	using simd::Mask;
+
+	const Vec zero = simd::broadcast(0.);
+	const Vec one = simd::broadcast(1.);
+	const Vec rad_sqr = simd::broadcast(radius * radius);
+
+	for (; k + simd::width <= num; k += simd::width) {
+		const Vec cx = fixed_center ? simd::broadcast(center_xs[0]) : simd::load(center_xs + k);
+		const Vec cy = fixed_center ? simd::broadcast(center_ys[0]) : simd::load(center_ys + k);
+		const Vec start_x = fixed_center ? simd::load(xs + k) : simd::broadcast(xs[0]);
+		const Vec start_y = fixed_center ? simd::load(ys + k) : simd::broadcast(ys[0]);
+		const Vec end_x = fixed_center ? simd::load(xs + k + 1) : simd::broadcast(xs[1]);
+		const Vec end_y = fixed_center ? simd::load(ys + k + 1) : simd::broadcast(ys[1]);
+
+		// same as smallDistanceAt
+		auto small_at = [&](Vec interpolate) -> Mask {
+			const Vec x = (one - interpolate) * start_x + interpolate * end_x;
+			const Vec y = (one - interpolate) * start_y + interpolate * end_y;
+			return (cx - x) * (cx - x) + (cy - y) * (cy - y) <= rad_sqr;
+		};
+
+		const Vec v_x = end_x - start_x;
+		const Vec v_y = end_y - start_y;
+		const Vec a = v_x * v_x + v_y * v_y;
+		const Vec b = (start_x - cx) * v_x + (start_y - cy) * v_y;
+		const Vec c = (start_x - cx) * (start_x - cx) + (start_y - cy) * (start_y - cy) - rad_sqr;
+
+		Vec mid = - b / a;
+		Vec discriminant = mid * mid - c / a;
+
+		const Mask small_at_zero = small_at(zero);
+		const Mask small_at_one = small_at(one);
+		const Mask small_at_mid = small_at(mid);
+		const Mask full = small_at_zero & small_at_one;
+
+		mid = small_at_mid ? mid : (small_at_zero ? zero : (small_at_one ? one : mid));
+		const Mask free_at_mid = small_at_mid | small_at_zero | small_at_one;
+		const Mask empty = ~full & (~free_at_mid | ((mid <= zero) & ~small_at_zero) | ((mid >= one) & ~small_at_one));
+
+		discriminant = simd::max(discriminant, zero);
+		const Vec sqrt_discr = simd::sqrt(discriminant);
+
+		const Vec lambda1 = mid - sqrt_discr;
+		const Vec innershift1 = simd::min(lambda1 + save_eps_half, simd::min(one, mid));
+		const Vec outershift1 = lambda1 - save_eps_half;
+		const Mask begin_ok = small_at_zero | ((innershift1 >= outershift1) & small_at(innershift1) & ~small_at(outershift1));
+
+		const Vec lambda2 = mid + sqrt_discr;
+		const Vec innershift2 = simd::max(lambda2 - save_eps_half, simd::max(zero, mid));
+		const Vec outershift2 = lambda2 + save_eps_half;
+		const Mask end_ok = small_at_one | ((innershift2 <= outershift2) & small_at(innershift2) & ~small_at(outershift2));
+
+		const Vec begin = small_at_zero ? zero : innershift1;
+		const Vec outer_begin = small_at_zero ? -eps : outershift1;
+		const Vec end = small_at_one ? one : innershift2;
+		const Vec outer_end = small_at_one ? one + eps : outershift2;
+		const Mask fallback = ~empty & ~(begin_ok & end_ok);
+
+		for (std::size_t lane = 0; lane < simd::width; ++lane) {
+			if (fallback[lane]) {
+				scalar(k + lane);
+			}
+			else if (empty[lane]) {
+				free[k + lane] = Interval();
+				if (outer != nullptr) { outer[k + lane] = Interval(); }
+			}
+			else {
+				free[k + lane] = Interval(begin[lane], end[lane]);
+				if (outer != nullptr) { outer[k + lane] = Interval(outer_begin[lane], outer_end[lane]); }
+			}
+		}
+	}
+#endif
+
+	for (; k < num; ++k) {
+		scalar(k);
+	}
+}
+
+void IntersectionAlgorithm::intersection_intervals(Point circle_center, distance_t radius, distance_t const* xs, distance_t const* ys,
+	std::size_t num_segments, Interval* free, Interval* outer /* = nullptr*/)
+{
+	intersection_intervals_kernel<true>(&circle_center.x, &circle_center.y, xs, ys, num_segments, radius, free, outer);
+}
+
+void IntersectionAlgorithm::intersection_intervals(distance_t const* center_xs, distance_t const* center_ys, std::size_t num_centers,
+	distance_t radius, Point line_start, Point line_end, Interval* free, Interval* outer /* = nullptr*/)
+{
+	const distance_t xs[] = {line_start.x, line_end.x};
+	const distance_t ys[] = {line_start.y, line_end.y};
+	intersection_intervals_kernel<false>(center_xs, center_ys, xs, ys, num_centers, radius, free, outer);
+}
+
 Ellipse segmentsToEllipse(Point const& a1, Point const& b1, Point const& a2, Point const& b2, distance_t distance)
 {
 	Ellipse e;
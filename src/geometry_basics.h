@@ -11,13 +11,20 @@
 #include <vector>
 #include <sstream>
 
-namespace unit_tests { void testGeometricBasics(); }
+namespace unit_tests { void testGeometricBasics(); void testIntersectionIntervals(); }
 
 //
 // distance_t
 //
 
+// Build with FLOAT_DISTANCE to use single precision, e.g., for GPS data where
+// the additional precision of double isn't needed. This halves the memory of
+// the coordinate arrays and doubles the number of SIMD lanes.
+#ifdef FLOAT_DISTANCE
+using distance_t = float;
+#else
 using distance_t = double;
+#endif
 
 //
 // Point
@@ -42,6 +49,9 @@ using PointID = ID<Point>;
 
 std::ostream& operator<<(std::ostream& out, const Point& p);
 
+// squared distance of the point to the segment from start to end
+distance_t segmentDistanceSqr(Point const& point, Point const& start, Point const& end);
+
 struct PointRange {
 	PointID begin;
 	PointID end;
@@ -319,7 +329,13 @@ std::ostream& operator<<(std::ostream& out, const CInterval& interval);
 class IntersectionAlgorithm
 {
 public:
+	// The interpolation parameters in [0,1] are refined up to save_eps, so eps
+	// has to be well above the precision of distance_t around 1.
+#ifdef FLOAT_DISTANCE
+	static constexpr distance_t eps = 1e-5f;
+#else
 	static constexpr distance_t eps = 1e-8;
+#endif
 	
    /*
     * Returns which section of the line segment from line_start to line_end is inside the circle given by circle_center and radius.
@@ -331,11 +347,30 @@ public:
 	* If y = 1 then y' = 1+eps, while if y < 1 then the distance at y' is more than the radius.
     */
 	static Interval intersection_interval(Point circle_center, distance_t radius, Point line_start, Point line_end, Interval * outer = nullptr);
+
+	/*
+	 * Batch versions of intersection_interval. They return exactly the same intervals,
+	 * but compute the common case for many segments at once in vectorized code. Only
+	 * segments which need the binary search are handed to intersection_interval.
+	 *
+	 * The first version takes one circle and the num_segments consecutive segments of a
+	 * polygonal chain with coordinates xs, ys, i.e., segment k goes from point k to k+1.
+	 * The second version takes one segment and num_centers circle centers. The results
+	 * are written to free[k] and, if given, outer[k].
+	 */
+	static void intersection_intervals(Point circle_center, distance_t radius, distance_t const* xs, distance_t const* ys,
+		std::size_t num_segments, Interval* free, Interval* outer = nullptr);
+	static void intersection_intervals(distance_t const* center_xs, distance_t const* center_ys, std::size_t num_centers,
+		distance_t radius, Point line_start, Point line_end, Interval* free, Interval* outer = nullptr);
 private:
 	IntersectionAlgorithm() {} // Make class static-only
 	static inline bool smallDistanceAt(distance_t interpolate, Point line_start, Point line_end, Point circle_center, distance_t radius_sqr);
 	static inline distance_t distanceAt(distance_t interpolate, Point line_start, Point line_end, Point circle_center);
 
+	template <bool fixed_center>
+	static void intersection_intervals_kernel(distance_t const* center_xs, distance_t const* center_ys,
+		distance_t const* xs, distance_t const* ys, std::size_t num, distance_t radius, Interval* free, Interval* outer);
+
 	static constexpr distance_t save_eps = 0.5 * eps;
 	static constexpr distance_t save_eps_half = 0.25 * eps;
 };
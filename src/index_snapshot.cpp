@@ -0,0 +1,313 @@
+#include "index_snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr uint64_t alignment = 64;
+
+uint64_t align(uint64_t pos)
+{
+	return (pos + alignment - 1) / alignment * alignment;
+}
+
+// pads the file to the alignment, writes the data there and returns its position
+uint64_t writeSection(std::ostream& file, void const* data, uint64_t size)
+{
+	static char const zeros[alignment] = {};
+
+	auto current = static_cast<uint64_t>(file.tellp());
+	auto pos = align(current);
+	file.write(zeros, pos - current);
+	file.write(static_cast<char const*>(data), size);
+
+	return pos;
+}
+
+// FNV-1a over 64-bit words, with a shift such that the high bits of a word
+// also change the low bits of the hash. The words are distributed to
+// independent lanes, such that the multiplications do not wait for each
+// other. Only the last part of the data may have a size which is not a
+// multiple of the block size.
+class Checksum
+{
+public:
+	static constexpr std::size_t num_lanes = 4;
+	static constexpr std::size_t block_size = num_lanes*sizeof(uint64_t);
+
+	void add(char const* data, std::size_t size)
+	{
+		std::size_t i = 0;
+		for (; i + block_size <= size; i += block_size) {
+			uint64_t words[num_lanes];
+			std::memcpy(words, data + i, sizeof(words));
+			for (std::size_t lane = 0; lane < num_lanes; ++lane) {
+				mix(hashes[lane], words[lane]);
+			}
+		}
+		for (; i < size; ++i) {
+			mix(hashes[0], static_cast<unsigned char>(data[i]));
+		}
+	}
+
+	uint64_t get() const
+	{
+		auto hash = hashes[0];
+		for (std::size_t lane = 1; lane < num_lanes; ++lane) {
+			mix(hash, hashes[lane]);
+		}
+		return hash;
+	}
+
+private:
+	uint64_t hashes[num_lanes] = {
+		14695981039346656037ull, 14695981039346656037ull + 1,
+		14695981039346656037ull + 2, 14695981039346656037ull + 3};
+
+	static void mix(uint64_t& hash, uint64_t word)
+	{
+		hash = (hash ^ word)*1099511628211ull;
+		hash ^= hash >> 32;
+	}
+};
+
+// the header with a zero checksum, which is hashed before the sections
+Checksum headerChecksum(IndexSnapshot::Header const& header)
+{
+	static_assert(sizeof(IndexSnapshot::Header) % Checksum::block_size == 0,
+		"the sections have to be hashed from the start of a block");
+
+	auto header_copy = header;
+	header_copy.checksum = 0;
+	Checksum checksum;
+	checksum.add(reinterpret_cast<char const*>(&header_copy), sizeof(header_copy));
+	return checksum;
+}
+
+std::string featureNames(CurveSignatures const& signatures)
+{
+	std::string names;
+	for (auto const& feature: signatures.getFeatures()) {
+		names += feature.name + "\n";
+	}
+	return names;
+}
+
+} // end anonymous namespace
+
+constexpr char const* IndexSnapshot::magic;
+constexpr uint32_t IndexSnapshot::version;
+
+IndexSnapshot::~IndexSnapshot()
+{
+	close();
+}
+
+bool IndexSnapshot::isIndexSnapshot(std::string const& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	char file_magic[8];
+	if (!file.read(file_magic, sizeof(file_magic))) { return false; }
+
+	return std::memcmp(file_magic, magic, sizeof(file_magic)) == 0;
+}
+
+void IndexSnapshot::write(std::string const& filename, Curves const& curves, std::vector<bool> const& is_removed,
+	DynamicTree::Data const& kd_tree_data, CurveSignatures const& signatures)
+{
+	assert(is_removed.size() == curves.size());
+
+	auto const tmp_filename = filename + ".tmp";
+	std::fstream file(tmp_filename, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		ERROR("Could not open index snapshot for writing: " << tmp_filename);
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = version;
+	header.distance_size = sizeof(distance_t);
+	header.node_size = sizeof(*kd_tree_data.nodes);
+	header.bucket_size = DynamicTree::StaticTree::bucket_size;
+	header.num_curves = curves.size();
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+	header.curve_store_pos = writeSection(file, nullptr, 0);
+	CurveStore::write(file, curves);
+	header.curve_store_size = static_cast<uint64_t>(file.tellp()) - header.curve_store_pos;
+
+	std::vector<uint8_t> removed_flags(is_removed.begin(), is_removed.end());
+	header.is_removed_pos = writeSection(file, removed_flags.data(), removed_flags.size());
+
+	auto const& kd = kd_tree_data;
+	auto const bucket_size = DynamicTree::StaticTree::bucket_size;
+	header.num_nodes = kd.num_nodes;
+	header.num_buckets = kd.num_buckets;
+	header.num_points = kd.num_points;
+	header.nodes_pos = writeSection(file, kd.nodes, kd.num_nodes*sizeof(*kd.nodes));
+	header.bucket_coordinates_pos = writeSection(file, kd.bucket_coordinates, kd.num_buckets*8*bucket_size*sizeof(distance_t));
+	header.values_pos = writeSection(file, kd.values, kd.num_buckets*bucket_size*sizeof(CurveID));
+
+	auto const names = featureNames(signatures);
+	auto const& signature_values = signatures.getValues();
+	header.feature_names_size = names.size();
+	header.feature_names_pos = writeSection(file, names.data(), names.size());
+	header.num_signature_values = signature_values.size();
+	header.signatures_max_coordinate = signatures.getMaxCoordinate();
+	header.signatures_pos = writeSection(file, signature_values.data(), signature_values.size()*sizeof(distance_t));
+	header.file_size = file.tellp();
+
+	// read everything back for the checksum
+	auto checksum = headerChecksum(header);
+	std::vector<char> buffer(Checksum::block_size << 15);
+	file.seekg(header.curve_store_pos);
+	while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+		checksum.add(buffer.data(), file.gcount());
+	}
+	file.clear();
+	header.checksum = checksum.get();
+
+	file.seekp(0);
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.close();
+	if (!file) {
+		ERROR("Error while writing index snapshot: " << tmp_filename);
+	}
+
+	if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+		ERROR("Could not rename " << tmp_filename << " to " << filename);
+	}
+}
+
+void IndexSnapshot::open(std::string const& filename)
+{
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		ERROR("Could not open index snapshot: " << filename);
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(Header)) {
+		::close(fd);
+		ERROR("Invalid index snapshot: " << filename);
+	}
+	mapping_size = file_stat.st_size;
+
+	mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		ERROR("Could not map index snapshot: " << filename);
+	}
+
+	auto base = static_cast<char const*>(mapping);
+	header = reinterpret_cast<Header const*>(base);
+	if (std::memcmp(header->magic, magic, sizeof(header->magic)) != 0) {
+		ERROR("Not an index snapshot: " << filename);
+	}
+	if (header->version != version || header->distance_size != sizeof(distance_t) ||
+	    header->node_size != sizeof(*DynamicTree::Data().nodes) ||
+	    header->bucket_size != DynamicTree::StaticTree::bucket_size) {
+		ERROR("Incompatible index snapshot version in " << filename << " (version "
+			<< header->version << ", distance size " << header->distance_size << ")");
+	}
+	if (header->file_size != mapping_size) {
+		ERROR("Truncated index snapshot: " << filename);
+	}
+
+	// the positions and sizes have to be checked before the sections are hashed
+	auto const size = header->file_size;
+	auto const bucket_size = DynamicTree::StaticTree::bucket_size;
+	auto fits = [&](uint64_t pos, uint64_t count, uint64_t element_size) {
+		return pos % alignment == 0 && pos >= sizeof(Header) && pos <= size && count <= (size - pos)/element_size;
+	};
+	if (!fits(header->curve_store_pos, header->curve_store_size, 1) ||
+	    !fits(header->is_removed_pos, header->num_curves, 1) ||
+	    !fits(header->nodes_pos, header->num_nodes, sizeof(*DynamicTree::Data().nodes)) ||
+	    !fits(header->bucket_coordinates_pos, header->num_buckets, 8*bucket_size*sizeof(distance_t)) ||
+	    !fits(header->values_pos, header->num_buckets, bucket_size*sizeof(CurveID)) ||
+	    !fits(header->feature_names_pos, header->feature_names_size, 1) ||
+	    !fits(header->signatures_pos, header->num_signature_values, sizeof(distance_t)) ||
+	    header->num_points > header->num_buckets*bucket_size || header->num_points > header->num_curves) {
+		ERROR("Invalid index snapshot (sections out of bounds): " << filename);
+	}
+	uint64_t const num_features = std::count(base + header->feature_names_pos,
+		base + header->feature_names_pos + header->feature_names_size, '\n');
+	auto const num_values = header->num_signature_values;
+	if (num_features == 0 ? num_values != 0 :
+	    num_values % num_features != 0 || num_values/num_features != header->num_curves) {
+		ERROR("Invalid index snapshot (wrong number of signature values): " << filename);
+	}
+
+	auto checksum = headerChecksum(*header);
+	checksum.add(base + header->curve_store_pos, header->file_size - header->curve_store_pos);
+	if (checksum.get() != header->checksum) {
+		ERROR("Corrupted index snapshot (checksum mismatch): " << filename);
+	}
+
+	curve_store.open(base + header->curve_store_pos, header->curve_store_size);
+	if (curve_store.size() != header->num_curves) {
+		ERROR("Invalid index snapshot (wrong number of curves): " << filename);
+	}
+}
+
+void IndexSnapshot::close()
+{
+	curve_store.close();
+	if (mapping != nullptr) {
+		munmap(mapping, mapping_size);
+	}
+
+	mapping = nullptr;
+	mapping_size = 0;
+	header = nullptr;
+}
+
+bool IndexSnapshot::isRemoved(std::size_t curve_index) const
+{
+	assert(is_open() && curve_index < header->num_curves);
+
+	auto base = static_cast<char const*>(mapping);
+	return base[header->is_removed_pos + curve_index] != 0;
+}
+
+DynamicTree::Data IndexSnapshot::getKdTreeData() const
+{
+	assert(is_open());
+
+	auto base = static_cast<char const*>(mapping);
+	DynamicTree::Data data;
+	data.nodes = reinterpret_cast<decltype(data.nodes)>(base + header->nodes_pos);
+	data.num_nodes = header->num_nodes;
+	data.bucket_coordinates = reinterpret_cast<distance_t const*>(base + header->bucket_coordinates_pos);
+	data.values = reinterpret_cast<CurveID const*>(base + header->values_pos);
+	data.num_buckets = header->num_buckets;
+	data.num_points = header->num_points;
+
+	return data;
+}
+
+bool IndexSnapshot::restoreSignatures(CurveSignatures& signatures) const
+{
+	assert(is_open());
+
+	auto base = static_cast<char const*>(mapping);
+	std::string const names(base + header->feature_names_pos, header->feature_names_size);
+	if (names != featureNames(signatures)) { return false; }
+
+	auto const values = reinterpret_cast<distance_t const*>(base + header->signatures_pos);
+	signatures.assign(values, header->num_signature_values, header->signatures_max_coordinate);
+	return true;
+}
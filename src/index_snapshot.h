@@ -0,0 +1,97 @@
+#pragma once
+
+#include "defs.h"
+#include "curves.h"
+#include "curve_store.h"
+#include "curve_signatures.h"
+#include "query_helper.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace unit_tests { void testIndexSnapshot(); }
+
+// Memory-mapped file with everything Query::getReady builds, such that a
+// restarted query process does not read any curve files or build the
+// kd-tree. The curves are an embedded CurveStore and thus views on the
+// mapped data. The arrays of the kd-tree (which contain the keys of the
+// curves, see toKdPoint) and of the curve signatures are copied by a single
+// memcpy each, such that the tree can be updated afterwards.
+//
+// File layout (all sections 64-byte aligned):
+//   Header
+//   CurveStore curve_store
+//   uint8_t is_removed[num_curves]
+//   DynamicTree::Data::nodes[num_nodes]
+//   distance_t bucket_coordinates[num_buckets*8*bucket_size]
+//   CurveID values[num_buckets*bucket_size]
+//   char feature_names[]             -- each terminated by '\n'
+//   distance_t signatures[num_signature_values]
+//
+// The checksum covers the header (with a zero checksum) and everything after
+// it. The positions and sizes in the header are checked against the file size
+// before.
+class IndexSnapshot
+{
+public:
+	static constexpr char const* magic = "FRINDEX_";
+	static constexpr uint32_t version = 2;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t distance_size; // sizeof(distance_t) of the writer
+		uint32_t node_size; // size of a kd-tree node of the writer
+		uint32_t bucket_size; // DynamicTree::StaticTree::bucket_size of the writer
+		uint64_t checksum;
+		uint64_t num_curves;
+		uint64_t curve_store_pos;
+		uint64_t curve_store_size;
+		uint64_t is_removed_pos;
+		uint64_t num_nodes;
+		uint64_t nodes_pos;
+		uint64_t num_buckets;
+		uint64_t num_points;
+		uint64_t bucket_coordinates_pos;
+		uint64_t values_pos;
+		uint64_t feature_names_pos;
+		uint64_t feature_names_size;
+		uint64_t num_signature_values;
+		uint64_t signatures_pos;
+		double signatures_max_coordinate;
+		uint64_t file_size;
+	};
+
+	IndexSnapshot() = default;
+	~IndexSnapshot();
+	IndexSnapshot(IndexSnapshot const&) = delete;
+	IndexSnapshot& operator=(IndexSnapshot const&) = delete;
+
+	// Checks the magic number at the beginning of the file.
+	static bool isIndexSnapshot(std::string const& filename);
+	// The file is written next to the given one and then renamed, such that
+	// a snapshot which is mapped at the moment can be replaced.
+	static void write(std::string const& filename, Curves const& curves, std::vector<bool> const& is_removed,
+		DynamicTree::Data const& kd_tree_data, CurveSignatures const& signatures);
+
+	// Maps the file and checks its version and checksum.
+	void open(std::string const& filename);
+	void close();
+	bool is_open() const { return mapping != nullptr; }
+
+	CurveStore const& getCurveStore() const { return curve_store; }
+	bool isRemoved(std::size_t curve_index) const;
+	DynamicTree::Data getKdTreeData() const;
+	// Assigns the saved signatures if they have the same features, and
+	// returns false otherwise.
+	bool restoreSignatures(CurveSignatures& signatures) const;
+
+private:
+	void* mapping = nullptr;
+	std::size_t mapping_size = 0;
+
+	Header const* header = nullptr;
+	CurveStore curve_store;
+};
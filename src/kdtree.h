@@ -4,12 +4,54 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <queue>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
-template <typename T, int k, typename V, typename D = T>
+namespace unit_tests { void testKdTree(); }
+
+// The near check of a KdTree has to provide
+//
+//   template <typename Report>
+//   void scan(T const* coordinates, std::size_t stride, std::size_t count,
+//       Point const& point, Distance distance, Report report) const;
+//
+// which calls report(i) for each i < count for which the i-th point of a
+// leaf bucket is <= 'distance' away from 'point'. Coordinate d of the i-th
+// point is coordinates[d*stride + i]. The stride is a multiple of 16 and the
+// coordinates are padded up to it, such that the scan can be vectorized.
+//
+// PointwiseNear implements the scan by a function which checks single points.
+template <typename Point, typename Distance>
+struct PointwiseNear
+{
+	using Check = std::function<bool(Point const&, Point const&, Distance distance)>;
+
+	template <typename F>
+	PointwiseNear(F const& check) : check(check) {}
+
+	template <typename T, typename Report>
+	void scan(T const* coordinates, std::size_t stride, std::size_t count,
+		Point const& point, Distance distance, Report report) const
+	{
+		for (std::size_t i = 0; i < count; ++i) {
+			Point bucket_point;
+			for (std::size_t d = 0; d < bucket_point.size(); ++d) {
+				bucket_point[d] = coordinates[d*stride + i];
+			}
+			if (check(bucket_point, point, distance)) { report(i); }
+		}
+	}
+
+private:
+	Check check;
+};
+
+template <typename T, int k, typename V, typename D = T, typename N = PointwiseNear<std::array<T, k>, D>>
 class KdTree
 {
 	static_assert(k > 0, "Template parameter k should be > 0.");
@@ -20,66 +62,124 @@ public:
 	using Value = V;
 	using Values = std::vector<Value>;
 	using Distance = D;
-	using NearChecker = std::function<bool(Point const&, Point const&, Distance distance)>;
+	using NearChecker = N;
+	// Has to be consistent with the NearChecker, i.e., a point is near for d
+	// iff point_distance(a, b) <= d, and at least as large as the difference
+	// of any single coordinate.
+	using PointDistance = std::function<Distance(Point const&, Point const&)>;
+
+	// maximum number of points in a leaf
+	static constexpr std::size_t bucket_size = 32;
+	// minimum number of points for which a subtree is built by a separate
+	// task, and the chunk size of the parallel search of the split dimension
+	static constexpr std::size_t parallel_build_size = 1 << 14;
+
+	// Order of the nodes in memory after the build. Heap is the level order of
+	// the tree. VanEmdeBoas recursively stores the top half of the levels
+	// before the subtrees below them, such that a path from the root to a
+	// leaf touches O(log_B n) cache lines for any cache line size B. The leaf
+	// buckets are stored in the same order as the leaves.
+	enum class Layout { Heap, VanEmdeBoas };
 
 	KdTree(NearChecker const& near_checker)
 		: is_near(near_checker) {}
+	KdTree(NearChecker const& near_checker, PointDistance const& point_distance)
+		: is_near(near_checker), point_distance(point_distance) {}
 
 	void add(Point const& point, Value value);
-	void build();
+	void build(Layout layout = Layout::Heap);
 	void clear();
 
 	// Fills the variable 'result' by all the points in the kdtree
 	// which are <= 'distance' away from 'point'
 	void search(Point const& point, Distance distance, Values& result) const;
 
+	// calls f(point, value) for all points of a built tree
+	template <typename F>
+	void forEachPoint(F f) const;
+
+	class BestFirstSearch;
+
 protected:
 	bool is_ready_for_search = false;
 	NearChecker is_near;
+	PointDistance point_distance;
 
-	// types: empty = -1, split = 0..k-1, leaf = k
+	// types: split = 0..k-1, leaf = k
 	// The split value gives the dimension which is used for the split
 	using Type = int;
 	using KdID = std::size_t;
+
+	// The tree used for the search. The nodes only contain what is needed
+	// for the traversal. The points of a leaf are stored in a bucket, in
+	// structure of arrays form, see NearChecker.
+	using NodeIndex = std::uint32_t;
+	static constexpr NodeIndex no_child = std::numeric_limits<NodeIndex>::max();
+	struct SearchNode
+	{
+		T split; // all points of the first child are <= split, of the second >= split
+		Type type;
+		// for leaves: the bucket and the number of points in it
+		NodeIndex children[2];
+
+		bool is_leaf() const { return type == k; }
+		NodeIndex bucket() const { return children[0]; }
+		NodeIndex bucketCount() const { return children[1]; }
+	};
+	std::vector<SearchNode> nodes;
+	// k*bucket_size coordinates per bucket, dimension by dimension
+	std::vector<T> bucket_coordinates;
+	// bucket_size values per bucket
+	Values values;
+
+public:
+	// The arrays of a built tree, such that it can be saved and restored
+	// without building it again. The buckets contain the points themselves.
+	struct Data
+	{
+		SearchNode const* nodes = nullptr;
+		std::size_t num_nodes = 0;
+		T const* bucket_coordinates = nullptr;
+		Value const* values = nullptr;
+		std::size_t num_buckets = 0;
+		std::size_t num_points = 0;
+	};
+	Data getData() const;
+	// replaces the points by the ones of a built tree
+	void assign(Data const& data);
+
+protected:
+
 	struct KdNode
 	{
-		KdID id = std::numeric_limits<KdID>::max();
-		Type type = -1;
 		Point point;
 		Value value;
-#ifdef CERTIFY
-		//maintain deletion information for orthogonal range search
-		enum class DeleteState { Present, MarkedDeleted, Deleted };
-		DeleteState delete_flag = DeleteState::Present;
-		bool is_deleted() { return delete_flag == DeleteState::Deleted; }
-		bool holds_value() { return delete_flag == DeleteState::Present; }
-#endif
 
 		KdNode() = default;
 		KdNode(Point const& point, Value value)
 			: point(point), value(value) {}
-
-		bool is_empty() const { return type == -1; }
-		bool is_inner() const { return type >= 0 && type < k; }
-		bool is_leaf() const { return type == k; }
 	};
 	using Tree = std::vector<KdNode>;
 
+	// The points added since the last build. Only used for building.
 	Tree tree;
 
 	// helper structs for the building process
 	using TreeIterator = typename Tree::iterator;
 
-	struct BuildElement
+	// The nodes of the tree in the order of the implicit heap, i.e., the
+	// children of the node with ID i have the IDs 2i+1 and 2i+2.
+	struct BuildNode
 	{
-		KdID id;
+		Type type = -1; // -1 for the gaps of the heap
+		T split;
 		TreeIterator begin;
 		TreeIterator end;
 
-		// BuildElement() = default;
-		BuildElement(KdID id, TreeIterator begin, TreeIterator end)
-			: id(id), begin(begin), end(end) {}
+		bool is_empty() const { return type == -1; }
+		bool is_leaf() const { return type == k; }
 	};
+	using BuildNodes = std::vector<BuildNode>;
 
 	struct Comp
 	{
@@ -95,93 +195,274 @@ protected:
 	};
 
 	int calcSplitDimension(TreeIterator begin, TreeIterator end) const;
+	// splits the points at the median until they fit into a bucket, with
+	// the node of the points at position id of the heap
+	void buildSubtree(BuildNodes& build_nodes, KdID id, TreeIterator begin, TreeIterator end);
+	// appends the IDs of the non-empty nodes of the subtree of the given
+	// height below id in van Emde Boas order
+	void appendVanEmdeBoasOrder(BuildNodes const& build_nodes, KdID id, std::size_t height, std::vector<KdID>& order) const;
+	void buildSearchNodes(BuildNodes const& build_nodes, std::vector<KdID> const& order);
+	// moves the points of a built tree back to the build tree
+	void unbuild();
+	// the point in the given slot of a bucket (i.e., bucket*bucket_size + i)
+	Point getPoint(std::size_t slot) const;
+};
+
+template <typename T, int k, typename V, typename D, typename N>
+constexpr typename KdTree<T, k, V, D, N>::NodeIndex KdTree<T, k, V, D, N>::no_child;
+template <typename T, int k, typename V, typename D, typename N>
+constexpr std::size_t KdTree<T, k, V, D, N>::bucket_size;
+template <typename T, int k, typename V, typename D, typename N>
+constexpr std::size_t KdTree<T, k, V, D, N>::parallel_build_size;
+
+// Yields the points of the kdtree lazily in increasing distance from the
+// query point, such that the caller can stop as soon as the distance is too
+// large. Subtrees are visited best-first by the lower bound on the distance
+// given by the splits on the way to them. Requires the PointDistance.
+template <typename T, int k, typename V, typename D, typename N>
+class KdTree<T, k, V, D, N>::BestFirstSearch
+{
+public:
+	BestFirstSearch(KdTree const& kd_tree, Point const& query_point,
+		Distance max_distance = std::numeric_limits<Distance>::max());
+
+	// Returns false if there is no further point within max_distance.
+	// Otherwise, sets value and distance of the next point.
+	bool next(Value& value, Distance& distance);
+
+private:
+	// a subtree with the lower bound of its distance, or a point (given by
+	// its bucket slot) with its distance (then is_point is set)
+	struct Element
+	{
+		Distance distance;
+		std::size_t index;
+		bool is_point;
+
+		bool operator>(Element const& other) const
+		{
+			return distance > other.distance || (distance == other.distance && is_point < other.is_point);
+		}
+	};
+
+	KdTree const& kd_tree;
+	Point query_point;
+	Distance max_distance;
+	std::priority_queue<Element, std::vector<Element>, std::greater<Element>> queue;
+
+	void push(Element const& element);
 };
 
-	template <typename T, int k, typename V, typename D>
-void KdTree<T, k, V, D>::add(Point const& point, Value value)
+	template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::add(Point const& point, Value value)
 {
+	unbuild();
 	tree.emplace_back(point, value);
 	is_ready_for_search = false;
 }
 
-	template <typename T, int k, typename V, typename D>
-void KdTree<T, k, V, D>::build()
+	template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::build(Layout layout)
+{
+	unbuild();
+	if (tree.empty()) {
+		is_ready_for_search = true;
+		return;
+	}
+	assert(tree.size() < no_child);
+
+	// The shape of the tree only depends on the number of points, so the
+	// heap is allocated up front and the subtrees are built independently.
+	// The larger part of a split has the ceiling of half of the points.
+	std::size_t height = 1;
+	for (auto size = tree.size(); size > bucket_size; size -= size/2) { ++height; }
+	BuildNodes build_nodes((KdID(1) << height) - 1);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel if(tree.size() >= parallel_build_size)
+	#pragma omp single
+#endif
+	buildSubtree(build_nodes, 0, tree.begin(), tree.end());
+
+	std::vector<KdID> order;
+	if (layout == Layout::VanEmdeBoas) {
+		std::size_t height = 0;
+		while ((std::size_t(1) << height) - 1 < build_nodes.size()) { ++height; }
+		appendVanEmdeBoasOrder(build_nodes, 0, height, order);
+	}
+	else {
+		for (KdID id = 0; id < build_nodes.size(); ++id) {
+			if (!build_nodes[id].is_empty()) { order.push_back(id); }
+		}
+	}
+	buildSearchNodes(build_nodes, order);
+	Tree().swap(tree);
+
+	is_ready_for_search = true;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::buildSubtree(BuildNodes& build_nodes, KdID id, TreeIterator begin, TreeIterator end)
 {
-	if (tree.empty()) { return; }
+	auto& node = build_nodes[id];
+	node.begin = begin;
+	node.end = end;
+
+	auto size = std::distance(begin, end);
+	if (size <= static_cast<decltype(size)>(bucket_size)) {
+		node.type = k;
+		return;
+	}
 
-	std::vector<BuildElement> build_stack;
-	build_stack.emplace_back(0, tree.begin(), tree.end());
+	// Find median
+	auto median = begin + size/2;
+	auto split_dimension = calcSplitDimension(begin, end);
+	std::nth_element(begin, median, end, Comp(split_dimension));
+	node.type = split_dimension;
+	node.split = median->point[split_dimension];
+
+	// the subtrees are disjoint ranges of the points and of the heap
+#ifdef WITH_OPENMP
+	#pragma omp task shared(build_nodes) if(size >= static_cast<decltype(size)>(parallel_build_size))
+#endif
+	buildSubtree(build_nodes, 2*id + 1, begin, median);
+	buildSubtree(build_nodes, 2*id + 2, median, end);
+}
 
-	// Give the points the correct IDs (which correspond to their
-	// final position in the tree vector)
-	while (!build_stack.empty()) {
-		auto current = build_stack.back();
-		build_stack.pop_back();
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::appendVanEmdeBoasOrder(BuildNodes const& build_nodes, KdID id, std::size_t height, std::vector<KdID>& order) const
+{
+	if (id >= build_nodes.size() || build_nodes[id].is_empty()) { return; }
+	if (height == 1) {
+		order.push_back(id);
+		return;
+	}
 
-		// If only a single element remains in the range
-		if (std::distance(current.begin, current.end) == 1) {
-			current.begin->id = current.id;
-			current.begin->type = k;
-			continue;
-		}
+	// the top half of the levels, then the subtrees rooted below it
+	auto const top_height = height/2;
+	appendVanEmdeBoasOrder(build_nodes, id, top_height, order);
 
-		// Find median
-		auto median = current.begin + std::distance(current.begin, current.end)/2;
-		auto split_dimension = calcSplitDimension(current.begin, current.end);
-		std::nth_element(current.begin, median, current.end, Comp(split_dimension));
+	auto const num_roots = KdID(1) << top_height;
+	auto const first_root = (id + 1)*num_roots - 1;
+	for (KdID root = first_root; root < first_root + num_roots && root < build_nodes.size(); ++root) {
+		appendVanEmdeBoasOrder(build_nodes, root, height - top_height, order);
+	}
+}
 
-		// Settle the median element
-		median->id = current.id;
-		median->type = split_dimension;
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::buildSearchNodes(BuildNodes const& build_nodes, std::vector<KdID> const& order)
+{
+	std::vector<NodeIndex> node_index(build_nodes.size(), no_child);
+	NodeIndex num_buckets = 0;
+	for (NodeIndex i = 0; i < order.size(); ++i) {
+		node_index[order[i]] = i;
+		if (build_nodes[order[i]].is_leaf()) { ++num_buckets; }
+	}
 
-		// Find correct IDs of remainng elments (and check for empty range before push)
-		if (current.begin < median) {
-			build_stack.emplace_back(2*current.id + 1, current.begin, median);
+	nodes.resize(order.size());
+	bucket_coordinates.assign(num_buckets*k*bucket_size, T());
+	values.assign(num_buckets*bucket_size, Value());
+
+	NodeIndex bucket = 0;
+	for (NodeIndex i = 0; i < order.size(); ++i) {
+		auto const& build_node = build_nodes[order[i]];
+		auto& node = nodes[i];
+		node.type = build_node.type;
+
+		if (!build_node.is_leaf()) {
+			// both children exist, as there are more points than fit into a bucket
+			node.split = build_node.split;
+			node.children[0] = node_index[2*order[i] + 1];
+			node.children[1] = node_index[2*order[i] + 2];
+			continue;
 		}
-		if (median + 1 < current.end) {
-			build_stack.emplace_back(2*current.id + 2, median + 1, current.end);
+
+		node.split = T();
+		node.children[0] = bucket;
+		node.children[1] = std::distance(build_node.begin, build_node.end);
+		auto coordinates = &bucket_coordinates[bucket*k*bucket_size];
+		std::size_t slot = 0;
+		for (auto it = build_node.begin; it != build_node.end; ++it, ++slot) {
+			for (std::size_t d = 0; d < k; ++d) {
+				coordinates[d*bucket_size + slot] = it->point[d];
+			}
+			values[bucket*bucket_size + slot] = it->value;
 		}
+		++bucket;
 	}
+}
 
-	// Build tree using the IDs
-	// There are 3 steps to this:
-	// 1) sort by ID (because that's the order in which the points will appear in the tree vector)
-	// 2) resize to largest id (as the tree vector has some gaps)
-	// 3) actually place the points at their correct id (starting from the back of the vector)
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::unbuild()
+{
+	if (!is_ready_for_search) { return; }
 
-	// 1)
-	auto sort_by_id = [](KdNode const& node1, KdNode const& node2) {
-		assert(node1.id != node2.id);
-		return node1.id < node2.id;
-	};
-	std::sort(tree.begin(), tree.end(), sort_by_id);
-	// 2)
-	auto number_of_points = tree.size();
-	tree.resize(tree.back().id + 1);
-	// 3)
-	for(int i = number_of_points - 1; i >= 0; --i) {
-		std::swap(tree[i], tree[tree[i].id]);
-	}
+	forEachPoint([&](Point const& point, Value value) { tree.emplace_back(point, value); });
+	nodes.clear();
+	bucket_coordinates.clear();
+	values.clear();
+	is_ready_for_search = false;
+}
 
-	is_ready_for_search = true;
+template <typename T, int k, typename V, typename D, typename N>
+auto KdTree<T, k, V, D, N>::getPoint(std::size_t slot) const -> Point
+{
+	auto coordinates = &bucket_coordinates[(slot/bucket_size)*k*bucket_size + slot%bucket_size];
+
+	Point point;
+	for (std::size_t d = 0; d < k; ++d) {
+		point[d] = coordinates[d*bucket_size];
+	}
+	return point;
 }
 
-template <typename T, int k, typename V, typename D>
-int KdTree<T, k, V, D>::calcSplitDimension(TreeIterator begin, TreeIterator end) const
+template <typename T, int k, typename V, typename D, typename N>
+int KdTree<T, k, V, D, N>::calcSplitDimension(TreeIterator begin, TreeIterator end) const
 {
+	// find min and max
+	auto find_min_max = [](TreeIterator begin, TreeIterator end, Point& min, Point& max) {
+		min.fill(std::numeric_limits<T>::max());
+		max.fill(std::numeric_limits<T>::lowest());
+		for (auto it = begin; it != end; ++it) {
+			for (std::size_t i = 0; i < k; ++i) {
+				min[i] = std::min(min[i], it->point[i]);
+				max[i] = std::max(max[i], it->point[i]);
+			}
+		}
+	};
+
 	Point min;
 	Point max;
-	min.fill(std::numeric_limits<T>::max());
-	max.fill(std::numeric_limits<T>::lowest());
+	auto const size = static_cast<std::size_t>(std::distance(begin, end));
+	if (size < 2*parallel_build_size) {
+		find_min_max(begin, end, min, max);
+	}
+	else {
+		// reduction over chunks of the points, which are scanned by separate tasks
+		auto const num_chunks = size/parallel_build_size;
+		std::vector<Point> chunk_min(num_chunks);
+		std::vector<Point> chunk_max(num_chunks);
+		for (std::size_t chunk = 0; chunk < num_chunks; ++chunk) {
+			auto const chunk_begin = begin + chunk*parallel_build_size;
+			auto const chunk_end = (chunk + 1 == num_chunks) ? end : chunk_begin + parallel_build_size;
+#ifdef WITH_OPENMP
+			#pragma omp task shared(chunk_min, chunk_max)
+#endif
+			find_min_max(chunk_begin, chunk_end, chunk_min[chunk], chunk_max[chunk]);
+		}
+#ifdef WITH_OPENMP
+		#pragma omp taskwait
+#endif
 
-	// find min and max
-	auto find_min_max = [&min, &max](KdNode const& node) {
-		for (std::size_t i = 0; i < k; ++i) {
-			min[i] = std::min(min[i], node.point[i]);
-			max[i] = std::max(max[i], node.point[i]);
+		min = chunk_min[0];
+		max = chunk_max[0];
+		for (std::size_t chunk = 1; chunk < num_chunks; ++chunk) {
+			for (std::size_t i = 0; i < k; ++i) {
+				min[i] = std::min(min[i], chunk_min[chunk][i]);
+				max[i] = std::max(max[i], chunk_max[chunk][i]);
+			}
 		}
-	};
-	std::for_each(begin, end, find_min_max);
+	}
 
 	// find dimension with largest difference
 	T max_difference = -1;
@@ -197,47 +478,142 @@ int KdTree<T, k, V, D>::calcSplitDimension(TreeIterator begin, TreeIterator end)
 	return max_dimension;
 }
 
-	template <typename T, int k, typename V, typename D>
-void KdTree<T, k, V, D>::clear()
+	template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::clear()
 {
 	tree.clear();
+	nodes.clear();
+	bucket_coordinates.clear();
+	values.clear();
 	is_ready_for_search = false;
 }
 
-template <typename T, int k, typename V, typename D>
-void KdTree<T, k, V, D>::search(Point const& query_point, Distance distance, Values& result) const
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::search(Point const& query_point, Distance distance, Values& result) const
 {
 	assert(is_ready_for_search);
+	if (nodes.empty()) { return; }
 
-	std::queue<KdID> search_queue;
+	std::queue<NodeIndex> search_queue;
 	search_queue.push(0);
 
 	while (!search_queue.empty()) {
 		auto current_index = search_queue.front();
-		auto const& kd_point = tree[current_index];
+		auto const& node = nodes[current_index];
 		search_queue.pop();
-		if (kd_point.is_empty()) { continue; }
 
-		// Check if this point is in range
-		if (is_near(kd_point.point, query_point, distance)) {
-			result.push_back(kd_point.value);
+		// Check which points of the bucket are in range
+		if (node.is_leaf()) {
+			auto const first_slot = node.bucket()*bucket_size;
+			is_near.scan(&bucket_coordinates[node.bucket()*k*bucket_size], bucket_size, node.bucketCount(),
+				query_point, distance, [&](std::size_t i) { result.push_back(values[first_slot + i]); });
+			continue;
 		}
-		if (kd_point.is_leaf()) { continue; }
 
 		// Search in subtrees
-		assert(kd_point.is_inner());
-
-		auto dimension = kd_point.type;
-		auto query_coord = query_point[dimension];
-		auto split_coord = kd_point.point[dimension];
+		auto query_coord = query_point[node.type];
 		// first child
-		if (query_coord - distance <= split_coord) {
-			assert(2*current_index + 1 < tree.size());
-			search_queue.push(2*current_index + 1);
+		if (query_coord - distance <= node.split) {
+			search_queue.push(node.children[0]);
+		}
+		// second child
+		if (query_coord + distance >= node.split) {
+			search_queue.push(node.children[1]);
+		}
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+auto KdTree<T, k, V, D, N>::getData() const -> Data
+{
+	assert(is_ready_for_search);
+
+	Data data;
+	data.nodes = nodes.data();
+	data.num_nodes = nodes.size();
+	data.bucket_coordinates = bucket_coordinates.data();
+	data.values = values.data();
+	data.num_buckets = values.size()/bucket_size;
+	for (auto const& node: nodes) {
+		if (node.is_leaf()) { data.num_points += node.bucketCount(); }
+	}
+	return data;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::assign(Data const& data)
+{
+	clear();
+
+	nodes.assign(data.nodes, data.nodes + data.num_nodes);
+	bucket_coordinates.assign(data.bucket_coordinates, data.bucket_coordinates + data.num_buckets*k*bucket_size);
+	values.assign(data.values, data.values + data.num_buckets*bucket_size);
+
+	is_ready_for_search = true;
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+template <typename F>
+void KdTree<T, k, V, D, N>::forEachPoint(F f) const
+{
+	assert(is_ready_for_search);
+
+	for (auto const& node: nodes) {
+		if (!node.is_leaf()) { continue; }
+		for (std::size_t i = 0; i < node.bucketCount(); ++i) {
+			auto slot = node.bucket()*bucket_size + i;
+			f(getPoint(slot), values[slot]);
+		}
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+KdTree<T, k, V, D, N>::BestFirstSearch::BestFirstSearch(KdTree const& kd_tree, Point const& query_point, Distance max_distance)
+	: kd_tree(kd_tree), query_point(query_point), max_distance(max_distance)
+{
+	assert(kd_tree.is_ready_for_search);
+	assert(kd_tree.point_distance);
+
+	if (!kd_tree.nodes.empty()) {
+		push({0, 0, false});
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+void KdTree<T, k, V, D, N>::BestFirstSearch::push(Element const& element)
+{
+	if (element.distance <= max_distance) {
+		queue.push(element);
+	}
+}
+
+template <typename T, int k, typename V, typename D, typename N>
+bool KdTree<T, k, V, D, N>::BestFirstSearch::next(Value& value, Distance& distance)
+{
+	while (!queue.empty()) {
+		auto current = queue.top();
+		queue.pop();
+
+		if (current.is_point) {
+			value = kd_tree.values[current.index];
+			distance = current.distance;
+			return true;
 		}
-		// second child (if it exists -- therefore we also have to check)
-		if (2*current_index + 2 < tree.size() && query_coord + distance >= split_coord) {
-			search_queue.push(2*current_index + 2);
+
+		auto const& node = kd_tree.nodes[current.index];
+		if (node.is_leaf()) {
+			auto const first_slot = node.bucket()*bucket_size;
+			for (auto slot = first_slot; slot < first_slot + node.bucketCount(); ++slot) {
+				push({kd_tree.point_distance(kd_tree.getPoint(slot), query_point), slot, true});
+			}
+			continue;
 		}
+
+		// Push subtrees with the distance to their side of the split
+		auto query_coord = query_point[node.type];
+		push({std::max<Distance>(current.distance, query_coord - node.split), node.children[0], false});
+		push({std::max<Distance>(current.distance, node.split - query_coord), node.children[1], false});
 	}
+
+	return false;
 }
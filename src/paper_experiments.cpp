@@ -25,6 +25,8 @@ void certificatesYesNoRuntime();
 void omitRulesExp();
 void deciderComparisonExp();
 void deciderCountFiltered();
+void parserThroughputExp();
+void intersectionIntervalsExp();
 
 namespace
 {
@@ -49,6 +51,8 @@ int main()
 	bool omit_rules = false;
 	bool decider_comparison = false;
 	bool decider_count_filtered = false;
+	bool parser_throughput = false;
+	bool intersection_intervals = false;
 
 	if (comparison) { comparisonExp(); }
 	if (parts_measurement) { partsMeasurementExp(); }
@@ -59,6 +63,8 @@ int main()
 	if (omit_rules) { omitRulesExp(); }
 	if (decider_comparison) { deciderComparisonExp(); }
 	if (decider_count_filtered) { deciderCountFiltered(); }
+	if (parser_throughput) { parserThroughputExp(); }
+	if (intersection_intervals) { intersectionIntervalsExp(); }
 }
 
 void printRow(std::vector<double> const& row, int precision = 3)
@@ -593,3 +599,124 @@ void deciderCountFiltered()
 		printDeciderTable(counts_minus, counts_plus);
 	}
 }
+
+void parserThroughputExp()
+{
+	std::cout << "Starting parser throughput experiment." << std::endl;
+
+	std::size_t num_data_sets = 3;
+
+	// MB/s of the stream based parser and of the pointer based parser
+	std::vector<double> stream_throughput;
+	std::vector<double> fast_throughput;
+
+	for (std::size_t d = 0; d < num_data_sets; ++d) {
+		std::ifstream data_file(curve_data_files[d]);
+		std::vector<std::string> curve_filenames;
+		std::string line;
+		while (std::getline(data_file, line)) {
+			curve_filenames.push_back(curve_directories[d] + line);
+		}
+
+		// untimed pass which reads all files, such that both parsers run on a
+		// warm page cache
+		double total_bytes = 0.;
+		std::vector<char> buffer(1 << 16);
+		for (auto const& filename: curve_filenames) {
+			std::ifstream file(filename, std::ios::binary);
+			while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+				total_bytes += file.gcount();
+			}
+		}
+
+		std::size_t stream_points = 0;
+		std::size_t fast_points = 0;
+
+		auto start = hrc::now();
+		for (auto const& filename: curve_filenames) {
+			std::ifstream file(filename);
+			Curve curve;
+			parser::readCurveWithStreams(file, curve);
+			stream_points += curve.size();
+		}
+		auto stream_time = std::chrono::duration_cast<ns>(hrc::now()-start).count();
+
+		start = hrc::now();
+		for (auto const& filename: curve_filenames) {
+			std::ifstream file(filename);
+			Curve curve;
+			parser::readCurve(file, curve);
+			fast_points += curve.size();
+		}
+		auto fast_time = std::chrono::duration_cast<ns>(hrc::now()-start).count();
+
+		if (stream_points != fast_points) {
+			std::cerr << "ERROR: Parsers read different number of points.\n";
+			std::exit(1);
+		}
+
+		stream_throughput.push_back(total_bytes/stream_time*1000.);
+		fast_throughput.push_back(total_bytes/fast_time*1000.);
+	}
+
+	printRow(stream_throughput, 1);
+	printRow(fast_throughput, 1);
+}
+
+void intersectionIntervalsExp()
+{
+	std::cout << "Starting intersection intervals experiment." << std::endl;
+
+	std::size_t num_data_sets = 3;
+	std::size_t max_curves = 200;
+
+	// million intervals per second of the scalar and of the batch version
+	std::vector<double> scalar_throughput;
+	std::vector<double> batch_throughput;
+
+	for (std::size_t d = 0; d < num_data_sets; ++d) {
+		std::ifstream data_file(curve_data_files[d]);
+		Curves curves;
+		std::string line;
+		while (curves.size() < max_curves && std::getline(data_file, line)) {
+			curves.push_back(parser::readCurve(curve_directories[d] + line));
+		}
+
+		// all intervals of the free space diagrams of consecutive curves at the
+		// distance of their first points
+		std::vector<Interval> free;
+		double num_intervals = 0.;
+		double scalar_time = 0.;
+		double batch_time = 0.;
+		for (std::size_t i = 0; i+1 < curves.size(); ++i) {
+			auto const& curve1 = curves[i];
+			auto const& curve2 = curves[i+1];
+			if (curve2.size() < 2) { continue; }
+			auto const distance = std::sqrt(curve1.front().dist_sqr(curve2.front()));
+			free.resize(curve2.size()-1);
+
+			auto start = hrc::now();
+			for (PointID p = 0; p < curve1.size(); ++p) {
+				for (PointID q = 0; q+1 < curve2.size(); ++q) {
+					free[q] = IntersectionAlgorithm::intersection_interval(curve1[p], distance, curve2[q], curve2[q+1]);
+				}
+			}
+			scalar_time += std::chrono::duration_cast<ns>(hrc::now()-start).count();
+
+			start = hrc::now();
+			for (PointID p = 0; p < curve1.size(); ++p) {
+				IntersectionAlgorithm::intersection_intervals(curve1[p], distance, curve2.xs(), curve2.ys(),
+					curve2.size()-1, free.data());
+			}
+			batch_time += std::chrono::duration_cast<ns>(hrc::now()-start).count();
+
+			num_intervals += double(curve1.size())*(curve2.size()-1);
+		}
+
+		scalar_throughput.push_back(num_intervals/scalar_time*1000.);
+		batch_throughput.push_back(num_intervals/batch_time*1000.);
+	}
+
+	printRow(scalar_throughput, 1);
+	printRow(batch_throughput, 1);
+}
@@ -2,8 +2,128 @@
 
 #include "defs.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
 #include <sstream>
 
+namespace
+{
+
+inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Parses the number at the beginning of the null-terminated string `begin`
+// with the same result as std::strtod (and thus std::stod). Numbers with at
+// most 19 significant digits and a small decimal exponent are converted
+// exactly without calling strtod: if the mantissa is at most 2^53 and the
+// exponent at most 22 in absolute value, the mantissa as well as the power of
+// ten are representable as doubles and a single multiplication or division is
+// correctly rounded. Everything else falls back to strtod. Returns the
+// position after the number, or begin if no number could be parsed.
+char const* parseNumber(char const* begin, double& value)
+{
+	static double const powers_of_ten[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	static constexpr uint64_t max_exact_mantissa = uint64_t(1) << 53;
+
+	auto fallback = [&]() {
+		char* end;
+		value = std::strtod(begin, &end);
+		return const_cast<char const*>(end);
+	};
+
+	char const* p = begin;
+	bool negative = false;
+	if (*p == '-' || *p == '+') {
+		negative = (*p == '-');
+		++p;
+	}
+
+	uint64_t mantissa = 0;
+	int num_digits = 0;
+	int exponent = 0;
+	bool any_digits = false;
+
+	// skip leading zeros as they don't count as significant digits
+	while (*p == '0') { ++p; any_digits = true; }
+	// hex floats
+	if (*p == 'x' || *p == 'X') { return fallback(); }
+	for (; isDigit(*p); ++p, ++num_digits) {
+		mantissa = 10*mantissa + (*p - '0');
+		any_digits = true;
+	}
+	if (*p == '.') {
+		++p;
+		if (num_digits == 0) {
+			while (*p == '0') { ++p; --exponent; any_digits = true; }
+		}
+		for (; isDigit(*p); ++p, ++num_digits, --exponent) {
+			mantissa = 10*mantissa + (*p - '0');
+			any_digits = true;
+		}
+	}
+	// e.g. "inf" or "nan"
+	if (!any_digits) { return fallback(); }
+	// the mantissa might have overflowed
+	if (num_digits > 19) { return fallback(); }
+
+	if (*p == 'e' || *p == 'E') {
+		char const* q = p + 1;
+		bool negative_exponent = false;
+		if (*q == '-' || *q == '+') {
+			negative_exponent = (*q == '-');
+			++q;
+		}
+		if (isDigit(*q)) {
+			int explicit_exponent = 0;
+			for (; isDigit(*q); ++q) {
+				if (explicit_exponent < 10000) {
+					explicit_exponent = 10*explicit_exponent + (*q - '0');
+				}
+			}
+			exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+			p = q;
+		}
+	}
+
+	if (mantissa > max_exact_mantissa || exponent < -22 || exponent > 22) {
+		return fallback();
+	}
+
+	value = static_cast<double>(mantissa);
+	if (exponent < 0) { value /= powers_of_ten[-exponent]; }
+	else { value *= powers_of_ten[exponent]; }
+	if (negative) { value = -value; }
+
+	return p;
+}
+
+// Returns the position after the whitespace separated token containing `pos`.
+inline char const* skipToken(char const* pos)
+{
+	while (*pos != '\0' && !isSpace(*pos)) { ++pos; }
+	return pos;
+}
+
+inline char const* skipSpaces(char const* pos)
+{
+	while (isSpace(*pos)) { ++pos; }
+	return pos;
+}
+
+} // end anonymous namespace
+
 namespace parser
 {
 
@@ -21,6 +141,61 @@ Curve readCurve(std::string filename)
 }
 
 void readCurve(std::ifstream& curve_file, Curve& curve)
+{
+	// Read the whole file into a buffer which is reused for subsequent calls.
+	static thread_local std::vector<char> buffer;
+
+	auto const start = curve_file.tellg();
+	curve_file.seekg(0, std::ios::end);
+	auto const end = curve_file.tellg();
+	if (start >= 0 && end >= start) {
+		auto const file_size = static_cast<std::size_t>(end - start);
+		curve_file.seekg(start);
+		buffer.resize(file_size + 1);
+		curve_file.read(buffer.data(), file_size);
+		buffer[curve_file.gcount()] = '\0';
+	}
+	else { // not seekable
+		curve_file.clear();
+		buffer.assign(std::istreambuf_iterator<char>(curve_file), std::istreambuf_iterator<char>());
+		buffer.push_back('\0');
+	}
+
+	// There is at most one point per line, so reserve enough space to avoid reallocations.
+	curve.reserve(curve.size() + std::count(buffer.begin(), buffer.end(), '\n') + 1);
+
+	// Each line starts with the two coordinates, the rest of the line is ignored.
+	char const* pos = buffer.data();
+	while (true) {
+		double x, y;
+
+		pos = skipSpaces(pos);
+		if (*pos == '\0') { break; }
+		char const* x_end = parseNumber(pos, x);
+		if (x_end == pos) {
+			ERROR("Invalid x coordinate in curve file: " << std::string(pos, skipToken(pos)));
+		}
+		pos = skipSpaces(skipToken(x_end));
+		if (*pos == '\0') { break; }
+		char const* y_end = parseNumber(pos, y);
+		if (y_end == pos) {
+			ERROR("Invalid y coordinate in curve file: " << std::string(pos, skipToken(pos)));
+		}
+		pos = skipToken(y_end);
+
+		// ignore rest of the line
+		while (*pos != '\0' && *pos != '\n') { ++pos; }
+
+		// ignore duplicate rows
+		Point const point{static_cast<distance_t>(x), static_cast<distance_t>(y)};
+		if (curve.size() && curve.back().x == point.x && curve.back().y == point.y) {
+			continue;
+		}
+		curve.push_back(point);
+	}
+}
+
+void readCurveWithStreams(std::ifstream& curve_file, Curve& curve)
 {
 	// Read everything into a stringstream.
 	std::stringstream ss;
@@ -4,10 +4,15 @@
 #include <fstream>
 #include <string>
 
+namespace unit_tests { void testParser(); }
+
 namespace parser
 {
 
 Curve readCurve(std::string filename);
 void readCurve(std::ifstream& curve_file, Curve& curve);
+// Slower reference implementation of the above, based on string streams and
+// std::stod. Only kept for comparison.
+void readCurveWithStreams(std::ifstream& curve_file, Curve& curve);
 
 } // namespace parser
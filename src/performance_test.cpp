@@ -9,7 +9,7 @@ void printUsage()
 {
 	std::cout <<
 		"Usage: ./frechet <curve_directory> <curve_data_file> <query_file_prefix> <alg_string>\n"
-		"With <alg_string> you choose the algorithm to be used (light, naive)."
+		"With <alg_string> you choose the algorithm to be used (light, naive, wavefront)."
 		"\n";
 }
 
@@ -51,6 +51,8 @@ int main(int argc, char* argv[])
 		std::cout << "\nTime measurements:\n";
 		std::cout << "==================\n";
 		std::cout << global::times;
+		FilterCascade::print(std::cout, query.getFilterStatistics());
 		global::times.reset();
+		query.resetFilterStatistics();
 	}
 }
@@ -4,9 +4,14 @@
 #include "filter.h"
 #include "frechet_light.h"
 #include "frechet_naive.h"
+#include "frechet_wavefront.h"
 #include "parser.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <limits>
+#include <queue>
 #include <sstream>
 #include <vector>
 #include <iomanip>
@@ -18,25 +23,46 @@
 namespace
 {
 
-inline static bool isNear(Tree::Point const& a, Tree::Point const& b, distance_t distance)
+// the smallest distance for which KdNear holds
+inline static distance_t kdDistance(Tree::Point const& a, Tree::Point const& b)
 {
+	distance_t dist_sqr = 0.;
 	for (size_t i = 0; i < 4; i += 2) {
 		auto d = (a[i] - b[i])*(a[i] - b[i]) + (a[i + 1] - b[i + 1])*(a[i + 1] - b[i + 1]);
-		if (d > distance*distance) { return false; }
+		dist_sqr = std::max(dist_sqr, d);
 	}
+	auto distance = std::sqrt(dist_sqr);
 	for (size_t i = 4; i < 8; ++i) {
-		auto d = std::abs(a[i] - b[i]);
-		if (d > distance) { return false; }
+		distance = std::max(distance, std::abs(a[i] - b[i]));
 	}
 
-	return true;
+	return distance;
+}
+
+void incrementFilteredBy(FilterCascade::Stage stage)
+{
+	switch (stage) {
+	case FilterCascade::Stage::BichromaticFarthestDistance:
+		global::times.incrementFilteredByBichromaticFarthestDistance();
+		break;
+	case FilterCascade::Stage::Greedy:
+		global::times.incrementFilteredByGreedy();
+		break;
+	case FilterCascade::Stage::Negative:
+		global::times.incrementFilteredByNegative();
+		break;
+	case FilterCascade::Stage::SimultaneousGreedy:
+		global::times.incrementFilteredBySimultaneousGreedy();
+		break;
+	}
 }
 
 } // end anonymous namespace
 
 Query::Query(std::string const& curve_directory)
 	: curve_directory(curve_directory)
-	, kd_tree(isNear)
+	, kd_tree(KdNear(), kdDistance)
+	, filter_cascade(true)
 #ifdef WITH_OPENMP
 	, num_threads(omp_get_max_threads())
 #else
@@ -59,7 +85,30 @@ Query::~Query()
 
 void Query::readCurveData(std::string const& curve_data_file)
 {
+	// the curves might be views on a previously mapped file, so they have to
+	// be dropped before it is unmapped
 	is_ready = false;
+	curve_data.clear();
+	is_removed.clear();
+	kd_tree.clear();
+	curve_store.close();
+	index_snapshot.close();
+
+	if (IndexSnapshot::isIndexSnapshot(curve_data_file)) {
+		loadIndex(curve_data_file);
+		return;
+	}
+
+	// binary curve stores are mapped and used without parsing or copying
+	if (CurveStore::isCurveStore(curve_data_file)) {
+		curve_store.open(curve_data_file);
+
+		curve_data.reserve(curve_store.size());
+		for (std::size_t i = 0; i < curve_store.size(); ++i) {
+			curve_data.push_back(curve_store.getCurve(i));
+		}
+		return;
+	}
 
 	// read filenames of curve files
 	std::ifstream file(curve_data_file);
@@ -74,23 +123,33 @@ void Query::readCurveData(std::string const& curve_data_file)
 		ERROR("The curve data file could not be opened: " << curve_data_file);
 	}
 
-	// read curves
-	curve_data.clear();
-	curve_data.reserve(curve_filenames.size());
+	// read curves (in parallel, but keeping the order of the data file)
+	curve_data.resize(curve_filenames.size());
 
-	for (auto const& curve_filename: curve_filenames) {
-		std::ifstream curve_file(curve_directory + curve_filename);
+	std::size_t const none = std::numeric_limits<std::size_t>::max();
+	std::size_t failed_index = none;
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 16) num_threads(num_threads)
+#endif
+	for (std::size_t i = 0; i < curve_filenames.size(); ++i) {
+		std::ifstream curve_file(curve_directory + curve_filenames[i]);
 		if (curve_file.is_open()) {
-			curve_data.emplace_back();
-			parser::readCurve(curve_file, curve_data.back());
-			curve_data.back().filename = curve_filename;
-
-			if (curve_data.back().empty()) { curve_data.pop_back(); }
+			parser::readCurve(curve_file, curve_data[i]);
+			curve_data[i].filename = curve_filenames[i];
 		}
 		else {
-			ERROR("A curve file could not be opened: " << curve_directory + curve_filename);
+#ifdef WITH_OPENMP
+			#pragma omp critical
+#endif
+			failed_index = std::min(failed_index, i);
 		}
 	}
+	if (failed_index != none) {
+		ERROR("A curve file could not be opened: " << curve_directory + curve_filenames[failed_index]);
+	}
+
+	auto is_empty = [](Curve const& curve) { return curve.empty(); };
+	curve_data.erase(std::remove_if(curve_data.begin(), curve_data.end(), is_empty), curve_data.end());
 }
 
 void Query::readQueryCurves(std::string const& query_curves_file)
@@ -116,6 +175,11 @@ void Query::readQueryCurves(std::string const& query_curves_file)
 	}
 
 	// read curves
+	std::size_t const none = std::numeric_limits<std::size_t>::max();
+	std::size_t failed_index = none;
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 16) num_threads(num_threads)
+#endif
 	for (std::size_t i = 0; i < curve_filenames.size(); ++i) {
 		std::ifstream curve_file(curve_directory + curve_filenames[i]);
 		if (curve_file.is_open()) {
@@ -123,9 +187,15 @@ void Query::readQueryCurves(std::string const& query_curves_file)
 			query_elements[i].curve.filename = curve_filenames[i];
 		}
 		else {
-			ERROR("A curve file could not be opened: " << curve_directory + curve_filenames[i]);
+#ifdef WITH_OPENMP
+			#pragma omp critical
+#endif
+			failed_index = std::min(failed_index, i);
 		}
 	}
+	if (failed_index != none) {
+		ERROR("A curve file could not be opened: " << curve_directory + curve_filenames[failed_index]);
+	}
 }
 
 void Query::setAlgorithm(std::string const& frechet_version)
@@ -145,9 +215,15 @@ void Query::setAlgorithm(std::string const& frechet_version)
 			thread_data.frechet = new FrechetNaive();
 		}
 	}
+	else if (frechet_version == "wavefront") {
+		frechet = new FrechetWavefront();
+		for (auto& thread_data: thread_data_vec) {
+			thread_data.frechet = new FrechetWavefront();
+		}
+	}
 	else {
 		ERROR("Unknown Frechet version: " << frechet_version << "\n"
-			  "Known Frechet versions: light, naive");
+			  "Known Frechet versions: light, naive, wavefront");
 	}
 }
 
@@ -155,17 +231,83 @@ void Query::getReady()
 {
 	results.clear();
 
+	// the kd-tree is kept up to date, e.g., after loading an index snapshot
+	if (is_ready) { return; }
+
 	//
 	// build all the data structures and make queries ready
 	//
 
 	// for sequential
+	is_removed.resize(curve_data.size(), false);
 	kd_tree.clear();
 	for (CurveID id = 0; id < curve_data.size(); ++id) {
+		if (is_removed[id]) { continue; }
 		auto const& curve = curve_data[id];
 		kd_tree.add(toKdPoint(curve), id);
 	}
 	kd_tree.build();
+	signatures.compute(curve_data);
+
+	is_ready = true;
+}
+
+CurveID Query::addCurve(Curve const& curve)
+{
+	if (curve.empty()) {
+		ERROR("Cannot add an empty curve.");
+	}
+
+	auto const curve_id = curve_data.size();
+	curve_data.push_back(curve);
+	is_removed.resize(curve_data.size(), false);
+	if (is_ready) {
+		kd_tree.add(toKdPoint(curve), curve_id);
+		signatures.add(curve);
+	}
+
+	return curve_id;
+}
+
+void Query::removeCurve(CurveID curve_id)
+{
+	assert(curve_id < curve_data.size());
+	is_removed.resize(curve_data.size(), false);
+	if (is_removed[curve_id]) { return; }
+
+	is_removed[curve_id] = true;
+	if (is_ready) {
+		kd_tree.remove(curve_id);
+	}
+}
+
+void Query::saveIndex(std::string const& filename)
+{
+	assert(is_ready);
+
+	// a single tree without removed points
+	kd_tree.build();
+	is_removed.resize(curve_data.size(), false);
+	IndexSnapshot::write(filename, curve_data, is_removed, kd_tree.getData(), signatures);
+}
+
+void Query::loadIndex(std::string const& filename)
+{
+	index_snapshot.open(filename);
+	auto const& store = index_snapshot.getCurveStore();
+
+	curve_data.reserve(store.size());
+	is_removed.resize(store.size());
+	for (std::size_t i = 0; i < store.size(); ++i) {
+		curve_data.push_back(store.getCurve(i));
+		is_removed[i] = index_snapshot.isRemoved(i);
+	}
+
+	kd_tree.assign(index_snapshot.getKdTreeData());
+	// the features of the signatures might have been changed since
+	if (!index_snapshot.restoreSignatures(signatures)) {
+		signatures.compute(curve_data);
+	}
 
 	is_ready = true;
 }
@@ -206,6 +348,83 @@ void Query::run(Curve const& curve, distance_t distance)
 	run_impl(curve, distance);
 }
 
+void Query::runKnn(Curve const& curve, std::size_t k)
+{
+	assert(is_ready);
+	results.clear();
+	results.emplace_back();
+	auto& result = results.back();
+
+	k = std::min(k, kd_tree.size());
+	if (k == 0) { return; }
+
+	// The kd-tree yields the curves by increasing lower bound. The k-th
+	// smallest upper bound of the curves seen so far bounds the k-th
+	// distance, so the search stops as soon as the lower bound exceeds it.
+	std::priority_queue<distance_t> upper_bounds;
+	auto bound = std::numeric_limits<distance_t>::max();
+	candidates.clear();
+	DynamicTree::BestFirstSearch search(kd_tree, toKdPoint(curve));
+	auto const query_signature = signatures.signature(curve);
+	CurveID candidate;
+	distance_t lower_bound;
+	while (search.next(candidate, lower_bound) && lower_bound <= bound) {
+		if (signatures.lowerBound(query_signature, candidate) > bound) { continue; }
+
+		candidates.push_back(candidate);
+		upper_bounds.push(Filter::upperBound(curve, curve_data[candidate]));
+		if (upper_bounds.size() > k) { upper_bounds.pop(); }
+		if (upper_bounds.size() == k) { bound = upper_bounds.top(); }
+	}
+
+	// Bisection over the k-th distance, where only the undecided curves are
+	// decided. Invariants: the accepted curves are closer than lower, the
+	// undecided ones lie in [lower, upper], and together there are at least k.
+	// At critical values the decider might answer no, so the upper bound is
+	// decided slightly above.
+	distance_t lower = 0.;
+	distance_t upper = bound*(1 + FrechetLight::critical_value_tolerance) + FrechetLight::eps;
+	CurveIDs accepted;
+	CurveIDs undecided;
+	for (auto candidate: candidates) {
+		if (knn_frechet.lessThanWithFilters(upper, curve, curve_data[candidate])) {
+			undecided.push_back(candidate);
+		}
+	}
+	assert(undecided.size() >= k);
+
+	CurveIDs yes, no;
+	while (upper - lower >= FrechetLight::eps) {
+		distance_t split = (upper + lower)/2.;
+		// with float, eps might be below the precision of the distances
+		if (split <= lower || split >= upper) { break; }
+
+		yes.clear();
+		no.clear();
+		for (auto curve_id: undecided) {
+			bool less = knn_frechet.lessThanWithFilters(split, curve, curve_data[curve_id]);
+			(less ? yes : no).push_back(curve_id);
+		}
+
+		if (accepted.size() + yes.size() >= k) {
+			upper = split;
+			undecided.swap(yes);
+		}
+		else {
+			lower = split;
+			accepted.insert(accepted.end(), yes.begin(), yes.end());
+			undecided.swap(no);
+		}
+	}
+
+	// ties within eps are broken arbitrarily
+	result.curve_ids = std::move(accepted);
+	result.curve_ids.insert(result.curve_ids.end(), undecided.begin(), undecided.end());
+	result.curve_ids.resize(k);
+	std::sort(result.curve_ids.begin(), result.curve_ids.end());
+	result.kth_distance = (upper + lower)/2.;
+}
+
 void Query::check_certificate(Certificate const& c, Times::CertType type) {
 #ifdef CERTIFY
 	if (c.isValid()) {
@@ -253,7 +472,10 @@ void Query::run_impl(Curve const& curve, distance_t distance)
 	global::times.stopKdSearch();
 	global::times.startCountingCandidatesEtc();
 
+	auto const query_signature = signatures.signature(curve);
 	for (auto candidate: candidates) {
+		if (signatures.lowerBound(query_signature, candidate) > distance) { continue; }
+
 		global::times.startFrechetQuery();
 		global::times.incrementCandidates();
 
@@ -261,55 +483,21 @@ void Query::run_impl(Curve const& curve, distance_t distance)
 		auto const& candidate_curve = curve_data[candidate];
 		auto const max_distance = distance;
 
-		//TODO rewrite as "for all positive filters do ..." and "for all negative filters do ..."? 
 		//TODO filter always reallocates traversal vector
 		Filter filter(query_curve, candidate_curve, max_distance);
 
-		if (filter.bichromaticFarthestDistance()) {
-			result.addCurve(candidate);
-			global::times.stopFrechetQuery();
-			global::times.incrementFilteredByBichromaticFarthestDistance();
-			check_certificate(filter.getCertificate(), Times::FILTER);
-			continue;
-		}
-
-		global::times.startGreedy();
-		global::times.startCountingGreedySteps();
-		PointID pos1;
-		PointID pos2;
-		if (filter.adaptiveGreedy(pos1, pos2)) {
-			result.addCurve(candidate);
-			global::times.stopGreedy();
-			global::times.stopCountingGreedySteps();
-			global::times.stopFrechetQuery();
-			global::times.incrementFilteredByGreedy();
-			check_certificate(filter.getCertificate(), Times::FILTER);
-			continue;
-		}
-		global::times.stopGreedy();
-		global::times.stopCountingGreedySteps();
-
-		global::times.startNegative();
-		if (filter.negative(pos1, pos2)) {
-			global::times.stopNegative();
-			global::times.stopFrechetQuery();
-			global::times.incrementFilteredByNegative();
-			assert(not filter.getCertificate().isValid());
-			check_certificate(filter.getCertificate(), Times::FILTER);
-			continue;
-		}
-		global::times.stopNegative();
-
-		global::times.startSimultaneousGreedy();
-		if (filter.adaptiveSimultaneousGreedy()) {
-			result.addCurve(candidate);
-			global::times.stopSimultaneousGreedy();
+		FilterCascade::Stage stage;
+		auto const decision = filter_cascade.decide(filter, stage);
+		if (decision != FilterCascade::Decision::Undecided) {
+			if (decision == FilterCascade::Decision::Yes) {
+				result.addCurve(candidate);
+			}
 			global::times.stopFrechetQuery();
-			global::times.incrementFilteredBySimultaneousGreedy();
+			incrementFilteredBy(stage);
+			assert(stage != FilterCascade::Stage::Negative || not filter.getCertificate().isValid());
 			check_certificate(filter.getCertificate(), Times::FILTER);
 			continue;
 		}
-		global::times.stopSimultaneousGreedy();
 
 		global::times.startCountingSplits();
 		global::times.startLessThan();
@@ -346,34 +534,29 @@ void Query::run_impl_parallel(Curve const& curve, distance_t distance, Result& r
 #endif
 	auto& frechet = *thread_data.frechet;
 	auto& candidates = thread_data.candidates;
+	auto& filter_cascade = thread_data.filter_cascade;
 
 	// perform query
 	candidates.clear();
 	kd_tree.search(toKdPoint(curve), distance, candidates);
 
+	auto const query_signature = signatures.signature(curve);
 	for (auto candidate: candidates) {
+		if (signatures.lowerBound(query_signature, candidate) > distance) { continue; }
+
 		auto const& query_curve = curve;
 		auto const& candidate_curve = curve_data[candidate];
 		auto const max_distance = distance;
 
 		Filter filter(query_curve, candidate_curve, max_distance);
 
-		if (filter.bichromaticFarthestDistance()) {
+		FilterCascade::Stage stage;
+		auto const decision = filter_cascade.decide(filter, stage);
+		if (decision == FilterCascade::Decision::Yes) {
 			result.addCurve(candidate);
 			continue;
 		}
-
-		PointID pos1;
-		PointID pos2;
-		if (filter.adaptiveGreedy(pos1, pos2)) {
-			result.addCurve(candidate);
-			continue;
-		}
-		if (filter.negative(pos1, pos2)) {
-			continue;
-		}
-		if (filter.adaptiveSimultaneousGreedy()) {
-			result.addCurve(candidate);
+		if (decision == FilterCascade::Decision::No) {
 			continue;
 		}
 		if (frechet.lessThan(max_distance, query_curve, candidate_curve)) {
@@ -482,6 +665,33 @@ void Query::printDataStats(bool as_table) const
 	}
 }
 
+void Query::setFilterOrder(FilterCascade::Order const& order, bool adaptive)
+{
+	filter_cascade.setOrder(order);
+	filter_cascade.setAdaptive(adaptive);
+	for (auto& thread_data: thread_data_vec) {
+		thread_data.filter_cascade.setOrder(order);
+		thread_data.filter_cascade.setAdaptive(adaptive);
+	}
+}
+
+FilterCascade::Statistics Query::getFilterStatistics() const
+{
+	auto statistics = filter_cascade.getStatistics();
+	for (auto const& thread_data: thread_data_vec) {
+		FilterCascade::add(statistics, thread_data.filter_cascade.getStatistics());
+	}
+	return statistics;
+}
+
+void Query::resetFilterStatistics()
+{
+	filter_cascade.resetStatistics();
+	for (auto& thread_data: thread_data_vec) {
+		thread_data.filter_cascade.resetStatistics();
+	}
+}
+
 void Query::setRules(std::array<bool,5> const& enable)
 {
 	frechet->setRules(enable);
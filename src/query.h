@@ -1,27 +1,49 @@
 #pragma once
 
 #include "frechet_abstract.h"
+#include "filter_cascade.h"
+#include "frechet_light.h"
 #include "geometry_basics.h"
 #include "query_helper.h"
 #include "times.h"
 #include "curves.h"
+#include "curve_store.h"
+#include "curve_signatures.h"
+#include "index_snapshot.h"
 
 #include <string>
 
+namespace unit_tests { void testQueryKnn(); }
+
 class Query
 {
 public:
 	Query(std::string const& curve_directory);
 	~Query();
 
+	// The curve data file is either a list of curve filenames (relative to the
+	// curve directory), a binary curve store created by create_curve_store, or
+	// an index snapshot (see saveIndex), after which getReady does nothing.
 	void readCurveData(std::string const& curve_data_file);
 	void readQueryCurves(std::string const& query_curves_file);
 	void setAlgorithm(std::string const& frechet_version);
 	void getReady();
 
+	// Updates of the curve data after getReady, which are seen by the next
+	// query without rebuilding the kd-tree. Removed curves keep their ID.
+	CurveID addCurve(Curve const& curve);
+	void removeCurve(CurveID curve_id);
+
+	// Saves the curves together with the kd-tree and the curve signatures, see
+	// IndexSnapshot. Compacts the kd-tree before.
+	void saveIndex(std::string const& filename);
+
 	void run();
 	void run_parallel();
 	void run(Curve const& curve, distance_t distance);
+	// Finds the k curves with the smallest Frechet distance to the curve. The
+	// result contains them together with the distance of the k-th nearest.
+	void runKnn(Curve const& curve, std::size_t k);
 
 	Results const& getResults() const;
 	void saveResults(std::string const& results_file) const;
@@ -33,6 +55,13 @@ public:
 	Curves const& getCurves() const;
 	void printDataStats(bool as_table = false) const;
 
+	// The order of the filters before the exact decider and whether it is
+	// adapted to their statistics, see FilterCascade. The statistics are
+	// summed up over all threads.
+	void setFilterOrder(FilterCascade::Order const& order, bool adaptive);
+	FilterCascade::Statistics getFilterStatistics() const;
+	void resetFilterStatistics();
+
 	// yes, this is ugly... but easiest way for testing.
 	void setRules(std::array<bool,5> const& enable);
 	void setPruningLevel(int pruning_level);
@@ -55,19 +84,27 @@ private:
 	std::string const curve_directory;
 
 	QueryElements query_elements;
+	CurveStore curve_store;
+	IndexSnapshot index_snapshot;
 	Curves curve_data;
+	std::vector<bool> is_removed;
 	CurveIDs candidates;
 	Results results;
 
-	Tree kd_tree;
+	DynamicTree kd_tree;
+	CurveSignatures signatures;
+	FilterCascade filter_cascade;
+	FrechetLight knn_frechet;
 
 	std::size_t num_threads;
 	struct ThreadData {
 		FrechetAbstract* frechet = nullptr;
 		CurveIDs candidates;
+		FilterCascade filter_cascade;
 	};
 	std::vector<ThreadData> thread_data_vec;
 
+	void loadIndex(std::string const& filename);
 	void run_impl(Curve const& curve, distance_t distance);
 	void run_impl_parallel(Curve const& curve, distance_t distance, Result& result);
 
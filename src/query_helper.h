@@ -1,9 +1,13 @@
 #pragma once
 
 #include "geometry_basics.h"
+#include "dynamic_kdtree.h"
 #include "kdtree.h"
 #include "curves.h"
+#include "simd.h"
 
+#include <array>
+#include <cmath>
 #include <vector>
 #include <iostream>
 
@@ -12,7 +16,67 @@
 // Tree
 //
 
-using Tree = KdTree<distance_t, 8, CurveID>;
+// The near check of the kd-tree of the curves (see toKdPoint): the start
+// points, the end points and the bounding box coordinates have to be within
+// the distance. Buckets are checked with vector compares if possible.
+struct KdNear
+{
+	using Point = std::array<distance_t, 8>;
+
+	template <typename Report>
+	void scan(distance_t const* coordinates, std::size_t stride, std::size_t count,
+		Point const& point, distance_t distance, Report report) const
+	{
+		std::size_t i = 0;
+
+#ifdef FRECHET_SIMD
+		// the coordinates are padded up to the stride, so no scalar rest is needed
+		if (stride % simd::width == 0) {
+			auto const dist = simd::broadcast(distance);
+			auto const dist_sqr = simd::broadcast(distance*distance);
+
+			for (; i < count; i += simd::width) {
+				auto near = ~simd::Mask();
+				for (std::size_t d = 0; d < 4; d += 2) {
+					auto const dx = simd::load(coordinates + d*stride + i) - simd::broadcast(point[d]);
+					auto const dy = simd::load(coordinates + (d + 1)*stride + i) - simd::broadcast(point[d + 1]);
+					near &= (dx*dx + dy*dy <= dist_sqr);
+				}
+				for (std::size_t d = 4; d < 8; ++d) {
+					auto const diff = simd::load(coordinates + d*stride + i) - simd::broadcast(point[d]);
+					near &= (diff <= dist) & (-diff <= dist);
+				}
+
+				for (std::size_t lane = 0; lane < simd::width && i + lane < count; ++lane) {
+					if (near[lane]) { report(i + lane); }
+				}
+			}
+		}
+#endif
+
+		for (; i < count; ++i) {
+			if (isNear(coordinates + i, stride, point, distance)) { report(i); }
+		}
+	}
+
+private:
+	static bool isNear(distance_t const* coordinates, std::size_t stride, Point const& point, distance_t distance)
+	{
+		for (std::size_t d = 0; d < 4; d += 2) {
+			auto const dx = coordinates[d*stride] - point[d];
+			auto const dy = coordinates[(d + 1)*stride] - point[d + 1];
+			if (dx*dx + dy*dy > distance*distance) { return false; }
+		}
+		for (std::size_t d = 4; d < 8; ++d) {
+			if (std::abs(coordinates[d*stride] - point[d]) > distance) { return false; }
+		}
+
+		return true;
+	}
+};
+
+using Tree = KdTree<distance_t, 8, CurveID, distance_t, KdNear>;
+using DynamicTree = DynamicKdTree<distance_t, 8, CurveID, distance_t, KdNear>;
 
 inline Tree::Point toKdPoint(Curve const& curve)
 {
@@ -52,6 +116,8 @@ using QueryElements = std::vector<QueryElement>;
 struct Result
 {
 	CurveIDs curve_ids;
+	// only for kNN queries: the distance of the k-th nearest curve
+	distance_t kth_distance = 0.;
 
 	void addCurve(CurveID curve_id)
 	{
@@ -1,5 +1,7 @@
 #include "shortest_certificate.h"
 
+#include <cstring>
+
 
 inline bool inFreeSpace(Curve& curve1, Curve& curve2, CPoint p1, CPoint p2, distance_t delta) {
 
@@ -2,6 +2,7 @@
 #include "frechet_light.h"
 #include "freespace_light_vis.h"
 
+#include <cstring>
 #include <map>
 #include <fstream>
 
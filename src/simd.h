@@ -0,0 +1,59 @@
+#pragma once
+
+#include "geometry_basics.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// Fixed width vectors of distance_t based on the vector extensions of GCC and
+// Clang. They are compiled to SSE2 by default and to AVX/AVX2 if the target
+// supports it (e.g. with -march=native). If the extensions are not available,
+// FRECHET_SIMD is not defined and callers have to fall back to scalar code.
+//
+// Comparisons return masks with all bits set in the lanes where they hold.
+// Masks can be combined with &, | and ~ and used in `mask ? a : b`.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FRECHET_SIMD
+
+namespace simd
+{
+
+#ifdef __AVX__
+constexpr std::size_t vector_bytes = 32;
+#else
+constexpr std::size_t vector_bytes = 16;
+#endif
+
+using Vec = distance_t __attribute__((vector_size(vector_bytes)));
+using Mask = decltype(Vec() <= Vec());
+
+constexpr std::size_t width = vector_bytes/sizeof(distance_t);
+
+inline Vec load(distance_t const* ptr)
+{
+	Vec v;
+	std::memcpy(&v, ptr, sizeof(Vec));
+	return v;
+}
+
+inline Vec broadcast(distance_t value)
+{
+	Vec v = {};
+	return v + value;
+}
+
+inline Vec sqrt(Vec v)
+{
+	for (std::size_t lane = 0; lane < width; ++lane) { v[lane] = std::sqrt(v[lane]); }
+	return v;
+}
+
+// same results as std::min and std::max lane by lane
+inline Vec min(Vec a, Vec b) { return (b < a) ? b : a; }
+inline Vec max(Vec a, Vec b) { return (a < b) ? b : a; }
+
+} // namespace simd
+
+#endif
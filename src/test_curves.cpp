@@ -1,6 +1,7 @@
 #include "defs.h"
 #include "frechet_light.h"
 #include "frechet_naive.h"
+#include "frechet_wavefront.h"
 #include "freespace_light_vis.h"
 #include "parser.h"
 #include "filter.h"
@@ -53,6 +54,10 @@ int main(int argc, char* argv[])
 		FrechetNaive frechet;
 		std::cout << (frechet.lessThan(distance, curve1, curve2) ? "LESS" : "GREATER") << "\n";
 	}
+	else if (frechet_version == "wavefront") {
+		FrechetWavefront frechet;
+		std::cout << (frechet.lessThan(distance, curve1, curve2) ? "LESS" : "GREATER") << "\n";
+	}
 	else if (frechet_version == "greedy") {
 		Filter filter(curve1, curve2, distance);
 		std::cout << (filter.greedy() ? "LESS" : "NOT CLEAR") << "\n";
@@ -76,6 +81,6 @@ int main(int argc, char* argv[])
 	}
 	else {
 		ERROR("Unknown Frechet version: " << frechet_version << "\n"
-		      "Known Frechet versions: light, naive");
+		      "Known Frechet versions: light, naive, wavefront");
 	}
 }
@@ -5,15 +5,35 @@
 #include "unit_tests.h"
 
 #include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <random>
 #include <unordered_set>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "defs.h"
+#include "dynamic_kdtree.h"
+#include "filter.h"
+#include "filter_cascade.h"
 #include "frechet_light.h"
+#include "frechet_naive.h"
+#include "frechet_wavefront.h"
+#include "index_snapshot.h"
+#include "kdtree.h"
 #include "parser.h"
 #include "priority_search_tree.h"
 #include "range_tree.h"
 #include "curves.h"
+#include "curve_store.h"
+#include "curve_signatures.h"
+#include "distance_matrix.h"
+#include "query.h"
 
 #ifdef CERTIFY
 #include "freespace_light_vis.h"
@@ -73,6 +93,45 @@ Curve getCurve3() {
 	return curve;
 }
 
+// random walk with steps in [-1, 1]^2
+Curve getRandomWalk(std::default_random_engine& gen, std::size_t size, Point start = {0., 0.}) {
+	std::uniform_real_distribution<distance_t> step(-1., 1.);
+
+	Curve curve;
+	Point point = start;
+	for (std::size_t i = 0; i < size; ++i) {
+		point = point + Point{step(gen), step(gen)};
+		curve.push_back(point);
+	}
+
+	return curve;
+}
+
+// Runs the function in a child process, as ERROR exits the process, and
+// returns whether it exited with an error. The function must not use OpenMP.
+bool exitsWithError(std::function<void()> const& function) {
+	std::cout << std::flush;
+	pid_t pid = fork();
+	if (pid == 0) {
+		// the error message is expected
+		std::freopen("/dev/null", "w", stderr);
+		function();
+		_exit(EXIT_SUCCESS);
+	}
+
+	int status;
+	waitpid(pid, &status, 0);
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+// Overwrites a value at the given position of a file.
+template <typename T>
+void patchFile(std::string const& filename, std::size_t pos, T value) {
+	std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+	file.seekp(pos);
+	file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
 // bool roughlyEqual(distance_t a, distance_t b)
 // {
 //     return std::abs(a-b) < 0.001;
@@ -88,11 +147,26 @@ void unit_tests::testAll()
 {
 	unit_tests::testPrioritySearchTree();
 	unit_tests::testGeometricBasics();
+	unit_tests::testIntersectionIntervals();
+	unit_tests::testFrechetNaive();
+	unit_tests::testFrechetWavefront();
+	unit_tests::testParser();
+	unit_tests::testCurveStore();
+	unit_tests::testDistanceMatrix();
+	unit_tests::testCurveSignatures();
+	unit_tests::testQueryKnn();
 #ifdef CERTIFY
 	unit_tests::testFreespaceLightVis();
 #endif
 	unit_tests::testLightCertificate();
+	unit_tests::testLightParallel();
+	unit_tests::testLightIncremental();
+	unit_tests::testLightExact();
 	unit_tests::testRangeTree();
+	unit_tests::testKdTree();
+	unit_tests::testDynamicKdTree();
+	unit_tests::testIndexSnapshot();
+	unit_tests::testFilterCascade();
 }
 
 void unit_tests::testGeometricBasics()
@@ -104,6 +178,9 @@ void unit_tests::testGeometricBasics()
 
 	TEST(p1.dist(p2) == 2);
 	TEST(p1.dist(p3) == 5);
+	TEST(segmentDistanceSqr(Point{1., 1.}, p1, p2) == 1);
+	TEST(segmentDistanceSqr(p3, p1, p2) == 17);
+	TEST(segmentDistanceSqr(p3, p1, p1) == 25);
 
 	// Test Curves
 	auto curve1 = getCurve1();
@@ -111,6 +188,368 @@ void unit_tests::testGeometricBasics()
 
 	TEST(curve1.size() == 2 && curve2.size() == 3);
 	TEST(curve1.curve_length(0, 1) == 2);
+
+	// Test padded coordinate arrays
+	auto curve3 = getCurve3();
+	auto padded_size = Curve::paddedSize(curve3.size());
+	TEST(padded_size % Curve::padding == 0 && padded_size >= curve3.size());
+	TEST(reinterpret_cast<uintptr_t>(curve3.xs()) % cache_line_size == 0);
+	for (std::size_t i = curve3.size(); i < padded_size; ++i) {
+		TEST(curve3.xs()[i] == curve3.back().x && curve3.ys()[i] == curve3.back().y);
+	}
+	TEST(std::vector<Point>(curve3.begin(), curve3.end()).size() == curve3.size());
+
+	// Test point distance checks, also across blocks
+	TEST(curve3.allPointsWithin({1.5, 1.}, 0, 8, 3.25));
+	TEST(!curve3.allPointsWithin({1.5, 1.}, 0, 8, 3.2));
+	TEST(!curve3.allPointsWithin({0., 0.}, 0, 8, 8.));
+	TEST(curve3.allPointsWithin({1., 2.}, 4, 8, 1.));
+	TEST(!curve3.allPointsWithin({1., 2.}, 3, 8, 1.));
+	TEST(curve3.allPointsWithin({1., 1.7}, 8, 8, 0.));
+}
+
+void unit_tests::testIntersectionIntervals()
+{
+	// random walk with some repeated points to also get degenerate segments
+	std::default_random_engine gen(42);
+	std::uniform_real_distribution<distance_t> step(-1., 1.);
+	Curve curve;
+	Point point{0., 0.};
+	for (std::size_t i = 0; i < 500; ++i) {
+		if (i % 50 != 0) { point = point + Point{step(gen), step(gen)}; }
+		curve.push_back(point);
+	}
+	auto const num_segments = curve.size() - 1;
+
+	auto equal = [](Interval const& a, Interval const& b) {
+		return a.begin == b.begin && a.end == b.end;
+	};
+
+	std::vector<Interval> free(num_segments), outer(num_segments);
+	for (distance_t radius: {0.1, 0.5, 1., 2., 5.}) {
+		// fixed circle center, consecutive segments
+		for (PointID c = 0; c < curve.size(); c += 37) {
+			IntersectionAlgorithm::intersection_intervals(curve[c], radius, curve.xs(), curve.ys(),
+				num_segments, free.data(), outer.data());
+			for (PointID i = 0; i < num_segments; ++i) {
+				Interval expected_outer;
+				auto expected = IntersectionAlgorithm::intersection_interval(curve[c], radius,
+					curve[i], curve[i+1], &expected_outer);
+				TEST(equal(free[i], expected) && equal(outer[i], expected_outer));
+			}
+		}
+
+		// fixed segment, consecutive circle centers
+		for (PointID s = 0; s < num_segments; s += 41) {
+			IntersectionAlgorithm::intersection_intervals(curve.xs(), curve.ys(), num_segments,
+				radius, curve[s], curve[s+1], free.data(), outer.data());
+			for (PointID i = 0; i < num_segments; ++i) {
+				Interval expected_outer;
+				auto expected = IntersectionAlgorithm::intersection_interval(curve[i], radius,
+					curve[s], curve[s+1], &expected_outer);
+				TEST(equal(free[i], expected) && equal(outer[i], expected_outer));
+			}
+		}
+	}
+}
+
+void unit_tests::testFrechetNaive()
+{
+	// random walks of different lengths, such that the rows run along the
+	// shorter curve in one order and along the longer one in the other
+	std::default_random_engine gen(7);
+
+	FrechetLight frechet_light;
+	FrechetNaive frechet_naive;
+	for (std::size_t size1: {2, 3, 20, 100}) {
+		for (std::size_t size2: {2, 17, 60}) {
+			auto curve1 = getRandomWalk(gen, size1);
+			auto curve2 = getRandomWalk(gen, size2);
+			auto distance = frechet_light.calcDistance(curve1, curve2);
+			for (distance_t factor: {0.5, 0.99, 1.01, 2.}) {
+				bool expected = frechet_light.lessThan(factor*distance, curve1, curve2);
+				TEST(frechet_naive.lessThan(factor*distance, curve1, curve2) == expected);
+				TEST(frechet_naive.lessThan(factor*distance, curve2, curve1) == expected);
+			}
+		}
+	}
+}
+
+void unit_tests::testFrechetWavefront()
+{
+	std::default_random_engine gen(11);
+
+	// tile sizes which do and do not divide the number of cells, and a single tile
+	FrechetLight frechet_light;
+	FrechetWavefront frechet_wavefront;
+	for (std::size_t tile_size: {1, 3, 16, 1000}) {
+		frechet_wavefront.setTileSize(tile_size);
+		for (std::size_t size1: {2, 33, 100}) {
+			for (std::size_t size2: {2, 49}) {
+				auto curve1 = getRandomWalk(gen, size1);
+				auto curve2 = getRandomWalk(gen, size2);
+				auto distance = frechet_light.calcDistance(curve1, curve2);
+				for (distance_t factor: {0.5, 0.99, 1.01, 2.}) {
+					bool expected = frechet_light.lessThan(factor*distance, curve1, curve2);
+					TEST(frechet_wavefront.lessThan(factor*distance, curve1, curve2) == expected);
+					TEST(frechet_wavefront.lessThan(factor*distance, curve2, curve1) == expected);
+				}
+			}
+		}
+	}
+}
+
+void unit_tests::testParser()
+{
+	std::string const curve_file = "parser_test.txt";
+
+	auto parse_both = [&](std::string const& content) {
+		{
+			std::ofstream f(curve_file);
+			f << content;
+		}
+		Curve fast, reference;
+		std::ifstream f1(curve_file);
+		parser::readCurve(f1, fast);
+		std::ifstream f2(curve_file);
+		parser::readCurveWithStreams(f2, reference);
+
+		bool equal = fast.size() == reference.size();
+		for (PointID i = 0; equal && i < fast.size(); ++i) {
+			equal = fast[i].x == reference[i].x && fast[i].y == reference[i].y;
+		}
+		return equal;
+	};
+
+	TEST(parse_both(""));
+	TEST(parse_both("1 2\n3 4\n"));
+	TEST(parse_both("1 2 0 1\n1 2 0 2\n-3.5 +4e2 ignored\n"));
+	TEST(parse_both("  0.000123\t-0.1e-3 x y z\r\n1.5abc 2.5\n7"));
+	TEST(parse_both("39.984702 116.318417 0 492 39744.1201851852 2008-10-23 02:53:04\n"));
+	TEST(parse_both("12345678901234567890.5 1e30\n0.1234567890123456789012 -0\n"));
+	TEST(parse_both("1e-300 .5\n007 5.\n"));
+	TEST(parse_both("inf -INF\n"));
+	// hex floats, also with leading zeros
+	TEST(parse_both("0x1p3 -0X1.8p1\n00x10 0x.8\n"));
+	std::ofstream(curve_file) << "0x1p3 -0x1.8p1\n";
+	auto const hex_curve = parser::readCurve(curve_file);
+	TEST(hex_curve.size() == 1 && hex_curve[0].x == 8. && hex_curve[0].y == -3.);
+
+	// duplicate rows are skipped
+	std::ofstream(curve_file) << "1 2\n1 2\n3 4\n";
+	TEST(parser::readCurve(curve_file).size() == 2);
+
+	// random numbers in different formats
+	std::default_random_engine e(42);
+	std::uniform_real_distribution<double> rand(-1000., 1000.);
+	std::stringstream ss;
+	for (int i = 0; i < 10000; ++i) {
+		ss << std::setprecision(i % 20 + 1) << (i % 3 == 0 ? std::scientific : std::defaultfloat)
+		   << rand(e) << " " << rand(e) << "\n";
+	}
+	TEST(parse_both(ss.str()));
+
+	std::remove(curve_file.c_str());
+}
+
+void unit_tests::testCurveStore()
+{
+	Curves curves = {getCurve1(), getCurve2(), getCurve3()};
+	curves[0].filename = "curve1.txt";
+	curves[1].filename = "curve2.txt";
+	curves[2].filename = "";
+
+	std::string const store_file = "curve_store_test.bin";
+	CurveStore::write(store_file, curves);
+	TEST(CurveStore::isCurveStore(store_file));
+
+	CurveStore store;
+	store.open(store_file);
+	TEST(store.size() == curves.size());
+
+	for (std::size_t i = 0; i < curves.size(); ++i) {
+		auto const curve = store.getCurve(i);
+		TEST(curve.is_view());
+		TEST(curve.filename == curves[i].filename);
+		TEST(curve.size() == curves[i].size());
+		for (PointID j = 0; j < curve.size(); ++j) {
+			TEST(curve[j].x == curves[i][j].x && curve[j].y == curves[i][j].y);
+			TEST(curve.curve_length(0, j) == curves[i].curve_length(0, j));
+		}
+		TEST(reinterpret_cast<uintptr_t>(curve.xs()) % cache_line_size == 0);
+		TEST(reinterpret_cast<uintptr_t>(curve.prefix_lengths()) % cache_line_size == 0);
+		TEST(curve.getExtremePoints().max_x == curves[i].getExtremePoints().max_x);
+		TEST(curve.getExtremePoints().min_y == curves[i].getExtremePoints().min_y);
+
+		// modifying a view must not touch the mapped data
+		auto copy = curve;
+		copy.push_back({10., 10.});
+		TEST(!copy.is_view() && copy.size() == curve.size() + 1);
+		TEST(store.getCurve(i).size() == curves[i].size());
+	}
+
+	store.close();
+
+	// corrupted headers and offsets are rejected instead of read out of bounds
+	auto rejects = [&](std::function<void()> const& corrupt) {
+		CurveStore::write(store_file, curves);
+		corrupt();
+		return exitsWithError([&]() { CurveStore().open(store_file); });
+	};
+	TEST(!rejects([]() {}));
+	TEST(rejects([&]() { patchFile<uint64_t>(store_file, offsetof(CurveStore::Header, num_curves), 100000); }));
+	TEST(rejects([&]() { patchFile<uint64_t>(store_file, offsetof(CurveStore::Header, x_pos), 1ull << 36); }));
+	TEST(rejects([&]() { patchFile<uint64_t>(store_file, offsetof(CurveStore::Header, names_pos), 64*1000); }));
+	// the second point offset is the end of the first curve
+	uint64_t offsets_pos;
+	std::ifstream(store_file, std::ios::binary).seekg(offsetof(CurveStore::Header, offsets_pos))
+		.read(reinterpret_cast<char*>(&offsets_pos), sizeof(offsets_pos));
+	TEST(rejects([&]() { patchFile<uint64_t>(store_file, offsets_pos + sizeof(uint64_t), 1ull << 40); }));
+
+	std::remove(store_file.c_str());
+}
+
+void unit_tests::testDistanceMatrix()
+{
+	std::default_random_engine gen(17);
+	Curves curves;
+	for (std::size_t i = 0; i < 12; ++i) {
+		curves.push_back(getRandomWalk(gen, 20 + 5*i));
+	}
+
+	FrechetLight frechet;
+	for (std::size_t band: {0, 1, 3, 20}) {
+		DistanceMatrix matrix;
+		matrix.compute(curves, band);
+		TEST(matrix.size() == curves.size());
+
+		for (std::size_t i = 0; i < curves.size(); ++i) {
+			for (std::size_t j = 0; j < curves.size(); ++j) {
+				bool in_band = band == 0 || (i > j ? i - j : j - i) <= band;
+				TEST(matrix.contains(i, j) == in_band);
+				if (!in_band) { continue; }
+
+				auto distance = frechet.calcDistance(curves[i], curves[j]);
+				TEST(std::abs(matrix.get(i, j) - distance) <= 1e-6*std::max<distance_t>(1., distance));
+				TEST(matrix.get(i, j) == matrix.get(j, i));
+			}
+		}
+
+		std::string const matrix_file = "distance_matrix_test.bin";
+		matrix.write(matrix_file);
+		DistanceMatrix read_matrix;
+		read_matrix.read(matrix_file);
+		std::remove(matrix_file.c_str());
+		TEST(read_matrix.size() == matrix.size() && read_matrix.getBand() == band);
+		for (std::size_t i = 0; i < curves.size(); ++i) {
+			for (std::size_t j = 0; j < curves.size(); ++j) {
+				if (matrix.contains(i, j)) { TEST(read_matrix.get(i, j) == matrix.get(i, j)); }
+			}
+		}
+	}
+
+	// near-identical neighbors, i.e., the same walk with slightly moved points
+	// and additional points on different segments, such that the relative
+	// slack of the brackets is below the error of the bisection
+	std::uniform_real_distribution<distance_t> noise(0., 1e-6);
+	Curves close_curves;
+	auto const base_curve = getRandomWalk(gen, 30);
+	for (std::size_t i = 0; i < 8; ++i) {
+		Curve curve;
+		for (PointID k = 0; k < base_curve.size(); ++k) {
+			curve.push_back(base_curve[k] + Point{noise(gen), noise(gen)});
+			if (k + 1 < base_curve.size() && (k + i)%3 == 0) {
+				auto const middle = base_curve[k] + (base_curve[k+1] - base_curve[k])*0.37;
+				curve.push_back(middle + Point{noise(gen), noise(gen)});
+			}
+		}
+		close_curves.push_back(curve);
+	}
+	DistanceMatrix close_matrix;
+	close_matrix.compute(close_curves, 0);
+	for (std::size_t i = 0; i < close_curves.size(); ++i) {
+		for (std::size_t j = 0; j < close_curves.size(); ++j) {
+			auto distance = frechet.calcDistance(close_curves[i], close_curves[j]);
+			TEST(std::abs(close_matrix.get(i, j) - distance) <= 2*FrechetLight::eps);
+		}
+	}
+}
+
+void unit_tests::testCurveSignatures()
+{
+	std::default_random_engine gen(29);
+	std::uniform_real_distribution<distance_t> offset(-1., 1.);
+	Curves curves;
+	for (std::size_t i = 0; i < 20; ++i) {
+		Point const start{offset(gen), offset(gen)};
+		curves.push_back(getRandomWalk(gen, 1 + 3*i, start));
+	}
+
+	// plugging in a feature: the x-coordinate of the start point
+	CurveSignatures signatures;
+	auto const num_default_features = signatures.getFeatures().size();
+	signatures.addFeature({"start_x", 1., [](Curve const& curve) { return curve.front().x; }});
+	TEST(signatures.getFeatures().size() == num_default_features + 1);
+	signatures.compute(curves);
+
+	FrechetLight frechet;
+	for (std::size_t i = 0; i < curves.size(); ++i) {
+		auto const signature = signatures.signature(curves[i]);
+		TEST(signature.size() == signatures.getFeatures().size());
+		TEST(signatures.lowerBound(signature, i) == 0.);
+		TEST(signature.back() == curves[i].front().x);
+
+		for (std::size_t j = 0; j < curves.size(); ++j) {
+			auto const distance = frechet.calcDistance(curves[i], curves[j]);
+			TEST(signatures.lowerBound(signature, j) <= distance + 1e-6);
+		}
+	}
+}
+
+void unit_tests::testQueryKnn()
+{
+	std::default_random_engine gen(19);
+	std::uniform_real_distribution<distance_t> offset(-20., 20.);
+	Curves curves;
+	for (std::size_t i = 0; i < 40; ++i) {
+		Point const start{offset(gen), offset(gen)};
+		curves.push_back(getRandomWalk(gen, 10 + i, start));
+		curves.back().filename = "curve" + std::to_string(i) + ".txt";
+	}
+
+	std::string const store_file = "query_knn_test.bin";
+	CurveStore::write(store_file, curves);
+	Query query("");
+	query.readCurveData(store_file);
+	query.getReady();
+
+	FrechetLight frechet;
+	for (std::size_t query_index: {0, 7, 39}) {
+		auto const& query_curve = query.getCurves()[query_index];
+		std::vector<distance_t> distances;
+		for (auto const& curve: query.getCurves()) {
+			distances.push_back(frechet.calcDistance(query_curve, curve));
+		}
+		auto sorted_distances = distances;
+		std::sort(sorted_distances.begin(), sorted_distances.end());
+
+		for (std::size_t k: {0, 1, 5, 40, 50}) {
+			query.runKnn(query_curve, k);
+			auto const& result = query.getResults()[0];
+			TEST(result.curve_ids.size() == std::min(k, curves.size()));
+			if (result.curve_ids.empty()) { continue; }
+
+			auto const kth_distance = sorted_distances[result.curve_ids.size()-1];
+			auto const tolerance = 1e-6*std::max<distance_t>(1., kth_distance);
+			TEST(std::abs(result.kth_distance - kth_distance) <= tolerance);
+			for (auto curve_id: result.curve_ids) {
+				TEST(distances[curve_id] <= kth_distance + tolerance);
+			}
+			TEST(std::unordered_set<CurveID>(result.curve_ids.begin(), result.curve_ids.end()).size() == result.curve_ids.size());
+		}
+	}
+
+	std::remove(store_file.c_str());
 }
 
 #ifdef CERTIFY
@@ -153,6 +592,92 @@ void unit_tests::testLightCertificate(std::string curve1file, std::string curve2
 
 }
 
+void unit_tests::testLightParallel()
+{
+	std::default_random_engine gen(3);
+
+	FrechetLight frechet;
+	FrechetLight frechet_parallel;
+	for (std::size_t box_size: {2, 7, 64}) {
+		frechet_parallel.setParallelBoxSize(box_size);
+		for (std::size_t size: {30, 300}) {
+			auto curve1 = getRandomWalk(gen, size);
+			auto curve2 = getRandomWalk(gen, size + 17);
+			auto distance = frechet.calcDistance(curve1, curve2);
+			for (distance_t factor: {0.5, 0.99, 1.01, 2.}) {
+				bool output = frechet.lessThan(factor*distance, curve1, curve2);
+				TEST(frechet_parallel.lessThan(factor*distance, curve1, curve2) == output);
+#ifdef CERTIFY
+				Certificate& c = frechet_parallel.computeCertificate();
+				TEST(c.isValid());
+				TEST(c.isYes() == output);
+				TEST(c.check());
+#endif
+			}
+		}
+	}
+}
+
+void unit_tests::testLightIncremental()
+{
+	std::default_random_engine gen(5);
+	std::uniform_int_distribution<std::size_t> num_appended(1, 5);
+
+	FrechetLight frechet;
+	FrechetLight frechet_incremental;
+	for (std::size_t size2: {1, 2, 80}) {
+		auto full_curve1 = getRandomWalk(gen, 120);
+		auto curve2 = getRandomWalk(gen, size2);
+		auto distance = frechet.calcDistance(full_curve1, curve2);
+
+		for (distance_t factor: {0.5, 1., 1.5, 3.}) {
+			// append a few points at a time and compare with deciding from scratch
+			Curve curve1;
+			curve1.push_back(full_curve1[0]);
+			frechet_incremental.startIncremental(factor*distance, curve1, curve2);
+			TEST(frechet_incremental.lessThanIncremental() == frechet.lessThan(factor*distance, curve1, curve2));
+			while (curve1.size() < full_curve1.size()) {
+				auto num = std::min(num_appended(gen), full_curve1.size() - curve1.size());
+				for (std::size_t i = 0; i < num; ++i) {
+					curve1.push_back(full_curve1[curve1.size()]);
+				}
+				TEST(frechet_incremental.lessThanIncremental() == frechet.lessThan(factor*distance, curve1, curve2));
+			}
+		}
+	}
+}
+
+void unit_tests::testLightExact()
+{
+	FrechetLight frechet;
+
+	// the distance is attained at the endpoints, at a point-segment distance,
+	// and at a monotonicity event (going back from 2 to 1)
+	Curve endpoints, point_segment, backwards, line;
+	for (Point point: {Point{0., 1.}, Point{3., 1.}}) { endpoints.push_back(point); }
+	for (Point point: {Point{0., 0.}, Point{1., 2.}, Point{3., 0.}}) { point_segment.push_back(point); }
+	for (Point point: {Point{0., 0.}, Point{2., 0.}, Point{1., 0.}, Point{3., 0.}}) { backwards.push_back(point); }
+	for (Point point: {Point{0., 0.}, Point{3., 0.}}) { line.push_back(point); }
+	TEST(frechet.calcDistanceExact(endpoints, line) == 1.);
+	TEST(frechet.calcDistanceExact(point_segment, line) == 2.);
+	TEST(frechet.calcDistanceExact(backwards, line) == 0.5);
+	TEST(frechet.calcDistanceExact(line, backwards) == 0.5);
+
+	std::default_random_engine gen(13);
+
+	for (std::size_t size: {1, 2, 10, 100, 300}) {
+		for (std::size_t i = 0; i < 5; ++i) {
+			auto curve1 = getRandomWalk(gen, size);
+			auto curve2 = getRandomWalk(gen, size/2 + 1);
+			auto distance = frechet.calcDistance(curve1, curve2);
+			auto exact_distance = frechet.calcDistanceExact(curve1, curve2);
+			TEST(std::abs(distance - exact_distance) <= 1e-6*std::max<distance_t>(1., distance));
+			TEST(Filter::lowerBound(curve1, curve2) <= exact_distance);
+			TEST(Filter::upperBound(curve1, curve2) >= exact_distance*(1 - 1e-6));
+		}
+	}
+}
+
 void unit_tests::testRangeTree()
 {
 	using Tree = RangeTree<double, int>;
@@ -319,5 +844,379 @@ void unit_tests::testPrioritySearchTree()
 	}
 }
 
+void unit_tests::testKdTree()
+{
+	using Tree = KdTree<double, 3, int>;
+
+	auto point_distance = [](Tree::Point const& a, Tree::Point const& b) {
+		double distance = 0.;
+		for (std::size_t i = 0; i < 3; ++i) {
+			distance = std::max(distance, std::abs(a[i] - b[i]));
+		}
+		return distance;
+	};
+	auto is_near = [&](Tree::Point const& a, Tree::Point const& b, double distance) {
+		return point_distance(a, b) <= distance;
+	};
+
+	std::default_random_engine gen(23);
+	std::uniform_real_distribution<double> coordinate(-10., 10.);
+	auto random_point = [&]() -> Tree::Point { return {coordinate(gen), coordinate(gen), coordinate(gen)}; };
+
+	for (auto layout: {Tree::Layout::Heap, Tree::Layout::VanEmdeBoas}) {
+		// the largest tree is built by several tasks
+		for (std::size_t size: {0, 1, 2, 7, 100, 1000, 40000}) {
+			Tree tree(is_near, point_distance);
+			std::vector<Tree::Point> points;
+			for (std::size_t i = 0; i < size; ++i) {
+				points.push_back(random_point());
+				tree.add(points.back(), i);
+				// adding to a built tree keeps the points added before
+				if (i == size/2) { tree.build(layout); }
+			}
+			tree.build(layout);
+
+			for (std::size_t j = 0; j < 10; ++j) {
+				auto const query_point = random_point();
+				std::vector<double> distances;
+				for (auto const& point: points) {
+					distances.push_back(point_distance(point, query_point));
+				}
+				auto sorted_distances = distances;
+				std::sort(sorted_distances.begin(), sorted_distances.end());
+
+				// all points in increasing distance
+				Tree::BestFirstSearch search(tree, query_point);
+				int value;
+				double distance;
+				std::unordered_set<int> values;
+				while (search.next(value, distance)) {
+					TEST(distance == sorted_distances[values.size()]);
+					TEST(distance == distances[value]);
+					values.insert(value);
+				}
+				TEST(values.size() == size);
+
+				// the range search and the bounded search find the same points
+				double const max_distance = 5.;
+				Tree::Values result;
+				tree.search(query_point, max_distance, result);
+				std::unordered_set<int> expected;
+				for (std::size_t i = 0; i < size; ++i) {
+					if (distances[i] <= max_distance) { expected.insert(i); }
+				}
+				TEST(std::unordered_set<int>(result.begin(), result.end()) == expected);
+				TEST(result.size() == expected.size());
+
+				Tree::BestFirstSearch bounded_search(tree, query_point, max_distance);
+				values.clear();
+				while (bounded_search.next(value, distance)) {
+					TEST(distance <= max_distance);
+					values.insert(value);
+				}
+				TEST(values == expected);
+			}
+		}
+	}
+
+	// the vectorized bucket scan of the curve tree agrees with the scalar check
+	std::uniform_real_distribution<distance_t> curve_coordinate(-1., 1.);
+	std::size_t const stride = 32;
+	std::vector<distance_t> coordinates(8*stride);
+	for (auto& coordinate: coordinates) { coordinate = curve_coordinate(gen); }
+	for (std::size_t count: {0, 1, 5, 31, 32}) {
+		for (std::size_t j = 0; j < 20; ++j) {
+			KdNear::Point point;
+			for (auto& coordinate: point) { coordinate = curve_coordinate(gen); }
+			distance_t const distance = 0.2*j;
+
+			std::vector<std::size_t> found;
+			KdNear().scan(coordinates.data(), stride, count, point, distance,
+				[&](std::size_t i) { found.push_back(i); });
+
+			std::vector<std::size_t> expected;
+			for (std::size_t i = 0; i < count; ++i) {
+				auto c = [&](std::size_t d) { return coordinates[d*stride + i]; };
+				bool near = true;
+				for (std::size_t d = 0; d < 4; d += 2) {
+					near &= (c(d) - point[d])*(c(d) - point[d]) + (c(d+1) - point[d+1])*(c(d+1) - point[d+1]) <= distance*distance;
+				}
+				for (std::size_t d = 4; d < 8; ++d) {
+					near &= std::abs(c(d) - point[d]) <= distance;
+				}
+				if (near) { expected.push_back(i); }
+			}
+			TEST(found == expected);
+		}
+	}
+}
+
+void unit_tests::testDynamicKdTree()
+{
+	using Tree = DynamicKdTree<double, 2, int>;
+
+	auto point_distance = [](Tree::Point const& a, Tree::Point const& b) {
+		return std::max(std::abs(a[0] - b[0]), std::abs(a[1] - b[1]));
+	};
+	auto is_near = [&](Tree::Point const& a, Tree::Point const& b, double distance) {
+		return point_distance(a, b) <= distance;
+	};
+
+	std::default_random_engine gen(29);
+	std::uniform_real_distribution<double> coordinate(-10., 10.);
+	auto random_point = [&]() -> Tree::Point { return {coordinate(gen), coordinate(gen)}; };
+
+	// random inserts and removes, checked against the remaining points
+	Tree tree(is_near, point_distance);
+	std::vector<Tree::Point> points;
+	std::vector<int> live;
+	for (int i = 0; i < 100; ++i) {
+		points.push_back(random_point());
+		tree.add(points.back(), i);
+		live.push_back(i);
+	}
+	tree.build();
+
+	for (std::size_t round = 0; round < 30; ++round) {
+		for (std::size_t i = 0; i < 50; ++i) {
+			points.push_back(random_point());
+			tree.add(points.back(), points.size() - 1);
+			live.push_back(points.size() - 1);
+		}
+		// more removes than inserts in the late rounds, such that the tree shrinks again
+		std::size_t const num_removes = round < 20 ? 20 : 80;
+		for (std::size_t i = 0; i < num_removes && !live.empty(); ++i) {
+			std::swap(live[gen() % live.size()], live.back());
+			tree.remove(live.back());
+			live.pop_back();
+		}
+		TEST(tree.size() == live.size());
+
+		auto const query_point = random_point();
+		double const max_distance = 3.;
+		std::unordered_set<int> expected;
+		std::vector<double> sorted_distances;
+		for (auto value: live) {
+			auto const distance = point_distance(points[value], query_point);
+			if (distance <= max_distance) { expected.insert(value); }
+			sorted_distances.push_back(distance);
+		}
+		std::sort(sorted_distances.begin(), sorted_distances.end());
+
+		Tree::Values result;
+		tree.search(query_point, max_distance, result);
+		TEST(std::unordered_set<int>(result.begin(), result.end()) == expected);
+		TEST(result.size() == expected.size());
+
+		Tree::BestFirstSearch search(tree, query_point);
+		int value;
+		double distance;
+		std::unordered_set<int> values;
+		while (search.next(value, distance)) {
+			TEST(distance == sorted_distances[values.size()]);
+			TEST(distance == point_distance(points[value], query_point));
+			values.insert(value);
+		}
+		TEST(values.size() == live.size());
+	}
+
+	// compacting keeps the points
+	tree.build();
+	TEST(tree.size() == live.size());
+	Tree::Values result;
+	tree.search({0., 0.}, 10., result);
+	TEST(std::unordered_set<int>(result.begin(), result.end()) == std::unordered_set<int>(live.begin(), live.end()));
+
+	// the queries see added and removed curves
+	std::string const store_file = "dynamic_kdtree_test.bin";
+	CurveStore::write(store_file, {getCurve1(), getCurve2()});
+	Query query("");
+	query.readCurveData(store_file);
+	query.setAlgorithm("light");
+	query.getReady();
+
+	auto const curve_id = query.addCurve(getCurve3());
+	query.run(getCurve3(), 0.);
+	TEST(query.getResults()[0].curve_ids == CurveIDs{curve_id});
+	query.removeCurve(curve_id);
+	query.run(getCurve3(), 0.);
+	TEST(query.getResults()[0].curve_ids.empty());
+	query.removeCurve(0);
+	query.runKnn(getCurve1(), 2);
+	TEST(query.getResults()[0].curve_ids == CurveIDs{1});
+
+	std::remove(store_file.c_str());
+}
+
+void unit_tests::testIndexSnapshot()
+{
+	std::default_random_engine gen(31);
+	std::uniform_real_distribution<distance_t> offset(-10., 10.);
+	auto random_curve = [&](std::size_t size) {
+		Point const start{offset(gen), offset(gen)};
+		return getRandomWalk(gen, size, start);
+	};
+
+	Curves curves;
+	for (std::size_t i = 0; i < 300; ++i) {
+		curves.push_back(random_curve(5 + i%20));
+		curves.back().filename = "curve" + std::to_string(i) + ".txt";
+	}
+
+	std::string const store_file = "index_snapshot_test.bin";
+	std::string const snapshot_file = "index_snapshot_test.idx";
+	CurveStore::write(store_file, curves);
+	Query query("");
+	query.readCurveData(store_file);
+	query.setAlgorithm("light");
+	query.getReady();
+	query.addCurve(random_curve(12));
+	query.removeCurve(3);
+	query.removeCurve(250);
+	query.saveIndex(snapshot_file);
+
+	TEST(IndexSnapshot::isIndexSnapshot(snapshot_file));
+	TEST(!CurveStore::isCurveStore(snapshot_file));
+	TEST(!IndexSnapshot::isIndexSnapshot(store_file));
+
+	Query loaded_query("");
+	loaded_query.readCurveData(snapshot_file);
+	loaded_query.setAlgorithm("light");
+	loaded_query.getReady();
+
+	auto const& loaded_curves = loaded_query.getCurves();
+	TEST(loaded_curves.size() == query.getCurves().size());
+	for (std::size_t i = 0; i < loaded_curves.size(); ++i) {
+		auto const& curve = query.getCurves()[i];
+		TEST(loaded_curves[i].size() == curve.size());
+		TEST(loaded_curves[i].filename == curve.filename);
+		TEST(loaded_curves[i].back().x == curve.back().x && loaded_curves[i].back().y == curve.back().y);
+	}
+
+	// same results, also for removed curves and after further updates
+	auto const& query_curves = query.getCurves();
+	for (int update = 0; update < 2; ++update) {
+		for (std::size_t i: {0, 3, 42, 250, 300}) {
+			for (distance_t distance: {0., 1., 3.}) {
+				query.run(query_curves[i], distance);
+				loaded_query.run(query_curves[i], distance);
+				auto expected = query.getResults()[0].curve_ids;
+				auto result = loaded_query.getResults()[0].curve_ids;
+				std::sort(expected.begin(), expected.end());
+				std::sort(result.begin(), result.end());
+				TEST(result == expected);
+			}
+			query.runKnn(query_curves[i], 5);
+			loaded_query.runKnn(query_curves[i], 5);
+			TEST(loaded_query.getResults()[0].curve_ids == query.getResults()[0].curve_ids);
+		}
+
+		auto const curve = random_curve(8);
+		TEST(loaded_query.addCurve(curve) == query.addCurve(curve));
+		query.removeCurve(42);
+		loaded_query.removeCurve(42);
+	}
+
+	// reading other curve data replaces the curves of the mapped file
+	loaded_query.readCurveData(store_file);
+	loaded_query.getReady();
+	TEST(loaded_query.getCurves().size() == curves.size());
+	loaded_query.run(curves[3], 0.);
+	TEST(loaded_query.getResults()[0].curve_ids == std::vector<CurveID>{3});
+	loaded_query.readCurveData(snapshot_file);
+	loaded_query.getReady();
+	TEST(loaded_query.getCurves().size() == curves.size() + 1);
+	loaded_query.run(curves[3], 0.);
+	TEST(loaded_query.getResults()[0].curve_ids.empty());
+
+	// corrupted headers are rejected, by their bounds or by the checksum
+	query.saveIndex(snapshot_file);
+	auto const valid_snapshot = [&]() {
+		std::ifstream file(snapshot_file, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}();
+	auto rejects = [&](std::size_t field_pos, uint64_t value) {
+		std::ofstream(snapshot_file, std::ios::binary) << valid_snapshot;
+		patchFile(snapshot_file, field_pos, value);
+		return exitsWithError([&]() { IndexSnapshot().open(snapshot_file); });
+	};
+	using Header = IndexSnapshot::Header;
+	Header header;
+	std::memcpy(&header, valid_snapshot.data(), sizeof(header));
+	TEST(!rejects(offsetof(Header, num_curves), header.num_curves));
+	TEST(rejects(offsetof(Header, num_nodes), 200000));
+	TEST(rejects(offsetof(Header, num_nodes), header.num_nodes - 1));
+	TEST(rejects(offsetof(Header, nodes_pos), header.nodes_pos + 64));
+	TEST(rejects(offsetof(Header, nodes_pos), 1ull << 36));
+	TEST(rejects(offsetof(Header, num_buckets), 1ull << 40));
+	TEST(rejects(offsetof(Header, num_signature_values), header.num_signature_values + 1));
+	TEST(rejects(offsetof(Header, curve_store_size), header.file_size));
+	TEST(rejects(offsetof(Header, num_curves), header.num_curves + 1));
+
+	std::remove(store_file.c_str());
+	std::remove(snapshot_file.c_str());
+}
+
+void unit_tests::testFilterCascade()
+{
+	using Stage = FilterCascade::Stage;
+	using Decision = FilterCascade::Decision;
+
+	std::default_random_engine gen(37);
+
+	// pairs of curves with a distance which is clearly below or above theirs
+	FrechetLight frechet;
+	struct Instance { Curve curve1; Curve curve2; distance_t distance; bool is_less; };
+	std::vector<Instance> instances;
+	for (std::size_t i = 0; i < 50; ++i) {
+		auto curve1 = getRandomWalk(gen, 20);
+		auto curve2 = getRandomWalk(gen, 20);
+		auto const distance = frechet.calcDistance(curve1, curve2);
+		instances.push_back({curve1, curve2, 1.1*distance, true});
+		instances.push_back({curve1, curve2, 0.9*distance, false});
+	}
+
+	// each order only decides correctly, and the statistics add up
+	auto order = FilterCascade::defaultOrder();
+	std::sort(order.begin(), order.end());
+	do {
+		FilterCascade cascade;
+		cascade.setOrder(order);
+		cascade.setAdaptive(false);
+		std::size_t num_decided = 0;
+		for (auto const& instance: instances) {
+			Filter filter(instance.curve1, instance.curve2, instance.distance);
+			Stage stage;
+			auto const decision = cascade.decide(filter, stage);
+			if (decision == Decision::Undecided) { continue; }
+
+			++num_decided;
+			TEST((decision == Decision::Yes) == instance.is_less);
+			TEST((stage == Stage::Negative) == (decision == Decision::No));
+		}
+
+		auto const statistics = cascade.getStatistics();
+		TEST(statistics[static_cast<std::size_t>(order[0])].calls == instances.size());
+		std::size_t num_hits = 0;
+		for (auto const& stage_statistics: statistics) {
+			num_hits += stage_statistics.hits;
+		}
+		TEST(num_hits == num_decided);
+	} while (std::next_permutation(order.begin(), order.end()));
+
+	// if all candidates are close, the negative filter moves to the end, also
+	// if it was not tried at the beginning
+	FilterCascade cascade;
+	cascade.setOrder({{Stage::SimultaneousGreedy, Stage::Greedy, Stage::BichromaticFarthestDistance, Stage::Negative}});
+	for (std::size_t i = 0; i < 4*FilterCascade::reorder_interval; ++i) {
+		auto const& instance = instances[2*(i % 50)];
+		Filter filter(instance.curve1, instance.curve2, 10*instance.distance);
+		Stage stage;
+		TEST(cascade.decide(filter, stage) == Decision::Yes);
+	}
+	TEST(cascade.getOrder().back() == Stage::Negative);
+	TEST(cascade.getStatistics()[static_cast<std::size_t>(Stage::Negative)].calls > 0);
+}
+
 // just in case anyone does anything stupid with this file...
 #undef TEST
@@ -12,5 +12,8 @@ namespace unit_tests
 
 	void testLightCertificate();
 	void testLightCertificate(std::string curve1file, std::string curve2file, distance_t distance);
+	void testLightParallel();
+	void testLightIncremental();
+	void testLightExact();
 
 }
@@ -0,0 +1,128 @@
+#include "defs.h"
+#include "frechet_light.h"
+#include "parser.h"
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Runs the decider on a benchmark query file (as created by
+// create_benchmark_decider) and either writes the decisions or compares them
+// with decisions written before. This is used to validate a build with a
+// different distance_t (see FLOAT_DISTANCE) against the double build.
+
+void printUsage()
+{
+	std::cout <<
+		"Usage: ./validate_decider <curve_directory> <benchmark_query_file> <decision_file> <mode>\n"
+		"With <mode> write, the decisions are written to <decision_file>.\n"
+		"With <mode> compare, they are compared with the decisions in <decision_file>.\n"
+		"\n";
+}
+
+struct DeciderQuery
+{
+	std::string curve1_file;
+	std::string curve2_file;
+	double distance;
+};
+using DeciderQueries = std::vector<DeciderQuery>;
+
+DeciderQueries readQueries(std::string const& filename)
+{
+	std::ifstream file(filename);
+	if (!file.is_open()) {
+		ERROR("The benchmark query file could not be opened: " << filename);
+	}
+
+	DeciderQueries queries;
+	DeciderQuery query;
+	while (file >> query.curve1_file >> query.curve2_file >> query.distance) {
+		queries.push_back(query);
+	}
+
+	return queries;
+}
+
+std::vector<bool> readDecisions(std::string const& filename)
+{
+	std::ifstream file(filename);
+	if (!file.is_open()) {
+		ERROR("The decision file could not be opened: " << filename);
+	}
+
+	std::vector<bool> decisions;
+	int decision;
+	while (file >> decision) {
+		decisions.push_back(decision != 0);
+	}
+
+	return decisions;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 5) {
+		printUsage();
+		ERROR("Wrong number of arguments passed.");
+	}
+
+	std::string curve_directory = argv[1];
+	std::string query_file = argv[2];
+	std::string decision_file = argv[3];
+	std::string mode = argv[4];
+	if (mode != "write" && mode != "compare") {
+		printUsage();
+		ERROR("Unknown mode: " << mode);
+	}
+
+	auto queries = readQueries(query_file);
+
+	FrechetLight frechet;
+	std::vector<bool> decisions;
+	for (auto const& query: queries) {
+		auto curve1 = parser::readCurve(curve_directory + query.curve1_file);
+		auto curve2 = parser::readCurve(curve_directory + query.curve2_file);
+		decisions.push_back(frechet.lessThanWithFilters(query.distance, curve1, curve2));
+	}
+
+	if (mode == "write") {
+		std::ofstream file(decision_file);
+		if (!file.is_open()) {
+			ERROR("The decision file could not be opened: " << decision_file);
+		}
+		for (bool decision: decisions) {
+			file << decision << "\n";
+		}
+		std::cout << "Wrote " << decisions.size() << " decisions (sizeof(distance_t) = "
+			<< sizeof(distance_t) << ").\n";
+		return 0;
+	}
+
+	auto const reference = readDecisions(decision_file);
+	if (reference.size() != decisions.size()) {
+		ERROR("Number of decisions does not match: " << reference.size() << " vs. " << decisions.size());
+	}
+
+	// For differing decisions, report how close the query distance is to the
+	// actual Frechet distance, relative to the latter.
+	std::size_t num_differences = 0;
+	for (std::size_t i = 0; i < decisions.size(); ++i) {
+		if (decisions[i] == reference[i]) { continue; }
+
+		auto const& query = queries[i];
+		auto curve1 = parser::readCurve(curve_directory + query.curve1_file);
+		auto curve2 = parser::readCurve(curve_directory + query.curve2_file);
+		auto distance = frechet.calcDistance(curve1, curve2);
+
+		std::cout << "Decisions differ: " << query.curve1_file << " " << query.curve2_file
+			<< " " << query.distance << " (reference " << reference[i] << ", relative gap "
+			<< std::abs(query.distance - distance)/distance << ")\n";
+		++num_differences;
+	}
+
+	std::cout << num_differences << " of " << decisions.size() << " decisions differ.\n";
+
+	return num_differences == 0 ? 0 : 1;
+}